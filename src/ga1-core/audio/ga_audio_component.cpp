@@ -1,4 +1,7 @@
 #include "ga_audio_component.h"
+
+#include "framework/ga_profiler.h"
+
 #include <cstdarg>
 #include <stdarg.h>
 
@@ -31,9 +34,17 @@ ga_audio_component::~ga_audio_component()
 
 void ga_audio_component::update(struct ga_frame_params* params)
 {
+	GA_PROFILE_SCOPE("sim/update/ga_audio_component");
+
 	_system->update();
 }
 
+void ga_audio_component::get_access(uint64_t* reads, uint64_t* writes) const
+{
+	*reads = ga_world::get_signature<ga_audio_state>();
+	*writes = ga_world::get_signature<ga_audio_state>();
+}
+
 // add a sound clip to the collection of available sounds
 unsigned int ga_audio_component::add_sound(char* path)
 {
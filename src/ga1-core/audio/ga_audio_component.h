@@ -10,6 +10,7 @@ public:
 	ga_audio_component(class ga_entity* ent, int num_channels=100);
 	virtual ~ga_audio_component();
 	virtual void update(struct ga_frame_params* params) override;
+	virtual void get_access(uint64_t* reads, uint64_t* writes) const override;
 
 #pragma region Basic Control
 
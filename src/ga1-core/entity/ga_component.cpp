@@ -27,3 +27,9 @@ void ga_component::update(ga_frame_params* params)
 void ga_component::late_update(ga_frame_params* params)
 {
 }
+
+void ga_component::get_access(uint64_t* reads, uint64_t* writes) const
+{
+	*reads = ~uint64_t(0);
+	*writes = ~uint64_t(0);
+}
@@ -9,8 +9,22 @@
 ** This file is distributed under the MIT License. See LICENSE.txt.
 */
 
+#include "ga_world.h"
+
 #include "framework/ga_frame_params.h"
 
+/*
+** State that component updates share but that isn't in world columns yet.
+** Each is a world component type only so updates can name it in their
+** read and write sets. Drawcall lists aren't here: every thread emits to
+** its own bucket.
+*/
+struct ga_transform_state {};
+struct ga_animation_state {};
+struct ga_physics_state {};
+struct ga_script_state {};
+struct ga_audio_state {};
+
 /*
 ** Base class component object.
 ** All entity functionality is expected to derive from this object.
@@ -26,6 +40,13 @@ public:
 	virtual void update(struct ga_frame_params* params);
 	virtual void late_update(struct ga_frame_params* params);
 
+	/*
+	** World component types that this type's update and late_update read
+	** and write, so ga_sim knows which types can update at the same time.
+	** The default claims everything, so the type updates alone.
+	*/
+	virtual void get_access(uint64_t* reads, uint64_t* writes) const;
+
 	const class ga_entity* get_entity() const { return _entity; }
 	class ga_entity* get_entity() { return _entity; }
 
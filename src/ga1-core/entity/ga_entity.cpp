@@ -10,7 +10,9 @@
 #include "ga_entity.h"
 #include "ga_component.h"
 
-ga_entity::ga_entity()
+#include "framework/ga_sim.h"
+
+ga_entity::ga_entity() : _sim(nullptr)
 {
 	_transform.make_identity();
 }
@@ -22,6 +24,10 @@ ga_entity::~ga_entity()
 void ga_entity::add_component(ga_component* comp)
 {
 	_components.push_back(comp);
+	if (_sim)
+	{
+		_sim->add_component(comp);
+	}
 }
 
 void ga_entity::update(ga_frame_params* params)
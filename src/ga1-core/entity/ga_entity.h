@@ -26,6 +26,7 @@ public:
 	~ga_entity();
 
 	void add_component(class ga_component* comp);
+	const std::vector<class ga_component*>& get_components() const { return _components; }
 
 	void update(struct ga_frame_params* params);
 	void late_update(struct ga_frame_params* params);
@@ -37,6 +38,25 @@ public:
 	void set_transform(const ga_mat4f& t) { _transform = t; }
 
 private:
+	friend class ga_sim;
+
 	std::vector<class ga_component*> _components;
 	ga_mat4f _transform;
+
+	// The sim updating this entity's components, once it's been added.
+	class ga_sim* _sim;
+};
+
+/*
+** World component for a ga_entity that still runs its own components.
+**
+** ga_sim keeps every added ga_entity in its world this way. To migrate a
+** component, move its data into a plain struct added to the same world
+** entity and its update into a ga_system over that column, then drop it
+** from the ga_entity. Both styles run side by side while that happens.
+** @see ga_world
+*/
+struct ga_legacy_entity
+{
+	ga_entity* _entity;
 };
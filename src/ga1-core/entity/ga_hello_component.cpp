@@ -20,3 +20,9 @@ ga_hello_component::~ga_hello_component()
 void ga_hello_component::update(ga_frame_params* params)
 {
 }
+
+void ga_hello_component::get_access(uint64_t* reads, uint64_t* writes) const
+{
+	*reads = 0;
+	*writes = 0;
+}
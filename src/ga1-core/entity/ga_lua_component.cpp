@@ -11,6 +11,8 @@
 
 #include "entity/ga_entity.h"
 #include "framework/ga_frame_params.h"
+#include "framework/ga_profiler.h"
+#include "jobs/ga_io.h"
 
 #include <lua.hpp>
 
@@ -27,7 +29,19 @@ ga_lua_component::ga_lua_component(ga_entity* ent, const char* path) : ga_compon
 	std::string fullpath = g_root_path;
 	fullpath += path;
 
-	int status = luaL_loadfile(_lua, fullpath.c_str());
+	// Read through ga_io rather than luaL_loadfile, so loading from a job
+	// doesn't block a worker. The '@' names the chunk after the file.
+	std::string source;
+	if (!ga_io::read_file(fullpath.c_str(), source))
+	{
+		std::cerr << "Failed to read script " << path << std::endl;
+		lua_close(_lua);
+		_lua = nullptr;
+		return;
+	}
+
+	std::string chunk_name = "@" + fullpath;
+	int status = luaL_loadbuffer(_lua, source.data(), source.size(), chunk_name.c_str());
 	if (status)
 	{
 		std::cerr << "Failed to load script " << path << ": " << lua_tostring(_lua, -1);
@@ -50,11 +64,19 @@ ga_lua_component::~ga_lua_component()
 
 void ga_lua_component::update(ga_frame_params* params)
 {
+	GA_PROFILE_SCOPE("sim/update/ga_lua_component");
+
 	if (_lua)
 	{
 	}
 }
 
+void ga_lua_component::get_access(uint64_t* reads, uint64_t* writes) const
+{
+	*reads = ga_world::get_signature<ga_transform_state, ga_script_state>();
+	*writes = ga_world::get_signature<ga_transform_state, ga_script_state>();
+}
+
 int ga_lua_component::lua_frame_params_get_input_left(lua_State* state)
 {
 	int arg_count = lua_gettop(state);
@@ -21,6 +21,7 @@ public:
 	virtual ~ga_lua_component();
 
 	virtual void update(struct ga_frame_params* params) override;
+	virtual void get_access(uint64_t* reads, uint64_t* writes) const override;
 
 private:
 	static int lua_frame_params_get_input_left(struct lua_State* state);
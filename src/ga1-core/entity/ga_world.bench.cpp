@@ -0,0 +1,177 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+/*
+** Entity layout benchmark.
+** Moves every entity by its velocity, once with ga_entity and a heap
+** component per entity, and once with the same data in ga_world columns.
+** Each entity also carries a payload the pass doesn't read, like the
+** components a real entity holds besides the ones being updated.
+**
+** Reports setup time and ns per entity per pass at 10k to 1M entities.
+** The pointer layout is timed both in allocation order and shuffled, as
+** it ends up once entities have come and gone for a while.
+*/
+
+#include "ga_component.h"
+#include "ga_entity.h"
+#include "ga_world.h"
+
+#include "math/ga_mat4f.h"
+#include "math/ga_vec3f.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+typedef std::chrono::high_resolution_clock ga_bench_clock_t;
+
+static const int k_entity_counts[] = { 10000, 100000, 1000000 };
+static const int k_passes = 5;
+static const float k_dt = 1.0f / 60.0f;
+
+struct bench_velocity
+{
+	ga_vec3f _velocity;
+};
+
+struct bench_payload
+{
+	float _data[16];
+};
+
+class bench_move_component : public ga_component
+{
+public:
+	bench_move_component(ga_entity* ent, const ga_vec3f& velocity) : ga_component(ent)
+	{
+		_velocity._velocity = velocity;
+		std::fill(_payload._data, _payload._data + 16, 0.0f);
+	}
+
+	virtual void update(ga_frame_params* params) override
+	{
+		get_entity()->translate(_velocity._velocity.scale_result(k_dt));
+	}
+
+private:
+	bench_velocity _velocity;
+	bench_payload _payload;
+};
+
+static ga_vec3f get_velocity(int i)
+{
+	return { float(i % 7), float(i % 5), float(i % 3) };
+}
+
+// Best of k_passes, in ns per entity.
+template<class T>
+static double time_passes(int count, T func)
+{
+	double best = 0.0;
+	for (int pass = 0; pass < k_passes; ++pass)
+	{
+		auto t0 = ga_bench_clock_t::now();
+		func();
+		auto t1 = ga_bench_clock_t::now();
+		double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / count;
+		best = pass == 0 ? ns : std::min(best, ns);
+	}
+	return best;
+}
+
+static void bench_pointers(int count)
+{
+	auto t0 = ga_bench_clock_t::now();
+	std::vector<ga_entity*> entities;
+	std::vector<ga_component*> components;
+	entities.reserve(count);
+	components.reserve(count);
+	for (int i = 0; i < count; ++i)
+	{
+		ga_entity* ent = new ga_entity();
+		components.push_back(new bench_move_component(ent, get_velocity(i)));
+		entities.push_back(ent);
+	}
+	auto t1 = ga_bench_clock_t::now();
+
+	// Update doesn't touch the params, so none are needed.
+	auto update = [&]()
+	{
+		for (ga_entity* ent : entities)
+		{
+			ent->update(nullptr);
+		}
+	};
+
+	double ordered = time_passes(count, update);
+
+	std::mt19937 random(1);
+	std::shuffle(entities.begin(), entities.end(), random);
+	double shuffled = time_passes(count, update);
+
+	printf("%10d %24s %10.2f %10.2f\n", count, "pointers, in order",
+		std::chrono::duration<double, std::milli>(t1 - t0).count(), ordered);
+	printf("%10d %24s %10s %10.2f\n", count, "pointers, shuffled", "", shuffled);
+
+	for (ga_component* c : components)
+	{
+		delete c;
+	}
+	for (ga_entity* ent : entities)
+	{
+		delete ent;
+	}
+}
+
+static void bench_columns(int count)
+{
+	auto t0 = ga_bench_clock_t::now();
+	ga_world* world = new ga_world();
+	for (int i = 0; i < count; ++i)
+	{
+		ga_entity_id entity = world->create();
+
+		ga_mat4f transform;
+		transform.make_identity();
+		world->add(entity, transform);
+		world->add(entity, bench_velocity{ get_velocity(i) });
+		world->add(entity, bench_payload());
+	}
+	auto t1 = ga_bench_clock_t::now();
+
+	double columns = time_passes(count, [world]()
+	{
+		world->each_archetype<ga_mat4f, bench_velocity>([](int count, const ga_entity_id* entities, ga_mat4f* transforms, bench_velocity* velocities)
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				transforms[i].translate(velocities[i]._velocity.scale_result(k_dt));
+			}
+		});
+	});
+
+	printf("%10d %24s %10.2f %10.2f\n", count, "columns",
+		std::chrono::duration<double, std::milli>(t1 - t0).count(), columns);
+
+	delete world;
+}
+
+int main(int argc, const char** argv)
+{
+	printf("%10s %24s %10s %10s\n", "entities", "layout", "setup ms", "ns/entity");
+	for (int count : k_entity_counts)
+	{
+		bench_pointers(count);
+		bench_columns(count);
+	}
+	return 0;
+}
@@ -0,0 +1,351 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_world.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+// Rows a column holds when it first gets storage.
+static const int k_initial_capacity = 16;
+
+static ga_component_info _ga_component_infos[k_max_component_types];
+static std::atomic<int> _ga_component_type_count(0);
+static std::mutex _ga_component_type_mutex;
+
+int ga_register_component_type(const ga_component_info& info)
+{
+	// Columns come from operator new, which only aligns so far.
+	assert(info._align <= alignof(std::max_align_t));
+
+	std::lock_guard<std::mutex> lock(_ga_component_type_mutex);
+	int type = _ga_component_type_count.load(std::memory_order_relaxed);
+
+	// Signatures are 64-bit masks. There's no way to carry on past them.
+	if (type >= k_max_component_types)
+	{
+		fprintf(stderr, "ga_world: more than %d component types\n", k_max_component_types);
+		abort();
+	}
+	_ga_component_infos[type] = info;
+	_ga_component_type_count.store(type + 1, std::memory_order_release);
+	return type;
+}
+
+const ga_component_info& ga_get_component_info(int type)
+{
+	assert(type < _ga_component_type_count.load(std::memory_order_acquire));
+	return _ga_component_infos[type];
+}
+
+static uint32_t get_index(ga_entity_id entity)
+{
+	return uint32_t(entity);
+}
+
+static uint32_t get_generation(ga_entity_id entity)
+{
+	return uint32_t(entity >> 32);
+}
+
+ga_archetype::ga_archetype(uint64_t signature) :
+	_signature(signature),
+	_count(0),
+	_capacity(0),
+	_entities(nullptr)
+{
+	for (int type = 0; type < k_max_component_types; ++type)
+	{
+		_column_index[type] = -1;
+		_add_edges[type] = nullptr;
+		_remove_edges[type] = nullptr;
+
+		if (has(type))
+		{
+			_column_index[type] = int(_types.size());
+			_types.push_back(type);
+			_columns.push_back(nullptr);
+		}
+	}
+}
+
+ga_archetype::~ga_archetype()
+{
+	for (size_t c = 0; c < _types.size(); ++c)
+	{
+		const ga_component_info& info = ga_get_component_info(_types[c]);
+		for (int row = 0; row < _count; ++row)
+		{
+			info._destroy(_columns[c] + row * info._size);
+		}
+		::operator delete(_columns[c]);
+	}
+	delete[] _entities;
+}
+
+void* ga_archetype::get_component(int type, int row) const
+{
+	return _columns[_column_index[type]] + row * ga_get_component_info(type)._size;
+}
+
+int ga_archetype::push(ga_entity_id entity)
+{
+	if (_count == _capacity)
+	{
+		grow();
+	}
+	_entities[_count] = entity;
+	return _count++;
+}
+
+ga_entity_id ga_archetype::erase(int row)
+{
+	for (size_t c = 0; c < _types.size(); ++c)
+	{
+		const ga_component_info& info = ga_get_component_info(_types[c]);
+		info._destroy(_columns[c] + row * info._size);
+	}
+	return erase_moved(row);
+}
+
+ga_entity_id ga_archetype::erase_moved(int row)
+{
+	int last = _count - 1;
+	ga_entity_id moved = k_null_entity;
+	if (row != last)
+	{
+		for (size_t c = 0; c < _types.size(); ++c)
+		{
+			const ga_component_info& info = ga_get_component_info(_types[c]);
+			info._move(_columns[c] + row * info._size, _columns[c] + last * info._size);
+		}
+		moved = _entities[row] = _entities[last];
+	}
+	_count--;
+	return moved;
+}
+
+void ga_archetype::grow()
+{
+	int capacity = std::max(_capacity * 2, k_initial_capacity);
+
+	ga_entity_id* entities = new ga_entity_id[capacity];
+	std::copy(_entities, _entities + _count, entities);
+	delete[] _entities;
+	_entities = entities;
+
+	for (size_t c = 0; c < _types.size(); ++c)
+	{
+		const ga_component_info& info = ga_get_component_info(_types[c]);
+		char* column = static_cast<char*>(::operator new(capacity * info._size));
+		for (int row = 0; row < _count; ++row)
+		{
+			info._move(column + row * info._size, _columns[c] + row * info._size);
+		}
+		::operator delete(_columns[c]);
+		_columns[c] = column;
+	}
+
+	_capacity = capacity;
+}
+
+ga_world::ga_world() : _entity_count(0)
+{
+	// New entities start out with no components.
+	get_archetype(0);
+}
+
+ga_world::~ga_world()
+{
+	for (ga_archetype* archetype : _archetype_list)
+	{
+		delete archetype;
+	}
+}
+
+ga_entity_id ga_world::create()
+{
+	uint32_t index;
+	if (!_free_records.empty())
+	{
+		index = _free_records.back();
+		_free_records.pop_back();
+	}
+	else
+	{
+		index = uint32_t(_records.size());
+		record_t record;
+		record._archetype = nullptr;
+		record._row = 0;
+		record._generation = 1;
+		_records.push_back(record);
+	}
+
+	record_t& record = _records[index];
+	ga_entity_id entity = (ga_entity_id(record._generation) << 32) | index;
+	record._archetype = _archetype_list[0];
+	record._row = record._archetype->push(entity);
+
+	_entity_count++;
+	return entity;
+}
+
+void ga_world::destroy(ga_entity_id entity)
+{
+	if (!get_record(entity))
+	{
+		return;
+	}
+
+	record_t& record = _records[get_index(entity)];
+	ga_entity_id moved = record._archetype->erase(record._row);
+	if (moved != k_null_entity)
+	{
+		_records[get_index(moved)]._row = record._row;
+	}
+
+	// Skip generation zero so no handle is ever the null entity.
+	record._archetype = nullptr;
+	record._generation = record._generation + 1 ? record._generation + 1 : 1;
+	_free_records.push_back(get_index(entity));
+
+	_entity_count--;
+}
+
+bool ga_world::is_alive(ga_entity_id entity) const
+{
+	return get_record(entity) != nullptr;
+}
+
+const ga_world::record_t* ga_world::get_record(ga_entity_id entity) const
+{
+	uint32_t index = get_index(entity);
+	if (index >= _records.size())
+	{
+		return nullptr;
+	}
+
+	const record_t& record = _records[index];
+	if (!record._archetype || record._generation != get_generation(entity))
+	{
+		return nullptr;
+	}
+	return &record;
+}
+
+ga_archetype* ga_world::get_archetype(uint64_t signature)
+{
+	auto it = _archetypes.find(signature);
+	if (it != _archetypes.end())
+	{
+		return it->second;
+	}
+
+	ga_archetype* archetype = new ga_archetype(signature);
+	_archetypes[signature] = archetype;
+	_archetype_list.push_back(archetype);
+	return archetype;
+}
+
+void* ga_world::get_component(ga_entity_id entity, int type) const
+{
+	const record_t* record = get_record(entity);
+	if (!record || !record->_archetype->has(type))
+	{
+		return nullptr;
+	}
+	return record->_archetype->get_component(type, record->_row);
+}
+
+void* ga_world::add_slot(ga_entity_id entity, int type)
+{
+	if (!get_record(entity))
+	{
+		return nullptr;
+	}
+
+	record_t* record = &_records[get_index(entity)];
+	ga_archetype* from = record->_archetype;
+	if (from->has(type))
+	{
+		void* component = from->get_component(type, record->_row);
+		ga_get_component_info(type)._destroy(component);
+		return component;
+	}
+
+	ga_archetype* to = from->_add_edges[type];
+	if (!to)
+	{
+		to = get_archetype(from->_signature | (uint64_t(1) << type));
+		from->_add_edges[type] = to;
+		to->_remove_edges[type] = from;
+	}
+
+	move_entity(record, to);
+	return to->get_component(type, record->_row);
+}
+
+void ga_world::remove_type(ga_entity_id entity, int type)
+{
+	if (!get_record(entity))
+	{
+		return;
+	}
+
+	record_t* record = &_records[get_index(entity)];
+	ga_archetype* from = record->_archetype;
+	if (!from->has(type))
+	{
+		return;
+	}
+
+	ga_archetype* to = from->_remove_edges[type];
+	if (!to)
+	{
+		to = get_archetype(from->_signature & ~(uint64_t(1) << type));
+		from->_remove_edges[type] = to;
+		to->_add_edges[type] = from;
+	}
+
+	move_entity(record, to);
+}
+
+void ga_world::move_entity(record_t* record, ga_archetype* to)
+{
+	ga_archetype* from = record->_archetype;
+	int from_row = record->_row;
+	int to_row = to->push(from->_entities[from_row]);
+
+	// Carry over what both have. Whatever the new archetype lacks is dropped.
+	for (int type : from->_types)
+	{
+		const ga_component_info& info = ga_get_component_info(type);
+		void* component = from->get_component(type, from_row);
+		if (to->has(type))
+		{
+			info._move(to->get_component(type, to_row), component);
+		}
+		else
+		{
+			info._destroy(component);
+		}
+	}
+
+	ga_entity_id moved = from->erase_moved(from_row);
+	if (moved != k_null_entity)
+	{
+		_records[get_index(moved)]._row = from_row;
+	}
+
+	record->_archetype = to;
+	record->_row = to_row;
+}
@@ -0,0 +1,272 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+** Handle to an entity in a ga_world. The low 32 bits index the world's
+** entity records, the high 32 count how many times the record has been
+** reused, so stale handles can be told apart. Zero is never a live entity.
+*/
+typedef uint64_t ga_entity_id;
+
+static const ga_entity_id k_null_entity = 0;
+
+/* Component types are tracked as bits in a 64-bit mask. */
+static const int k_max_component_types = 64;
+
+/*
+** How a world moves and destroys components of one type.
+*/
+struct ga_component_info
+{
+	size_t _size;
+	size_t _align;
+
+	// Move-constructs dst from src, then destroys src.
+	void (*_move)(void* dst, void* src);
+	void (*_destroy)(void* component);
+};
+
+/* Assigns the next dense id. Aborts past k_max_component_types. */
+int ga_register_component_type(const ga_component_info& info);
+const ga_component_info& ga_get_component_info(int type);
+
+/*
+** Dense id for component type T, assigned on first use.
+** Any movable type can be a component.
+*/
+template<class T>
+struct ga_component_type
+{
+	static int get_id()
+	{
+		static const int id = ga_register_component_type(get_info());
+		return id;
+	}
+
+	static ga_component_info get_info()
+	{
+		ga_component_info info;
+		info._size = sizeof(T);
+		info._align = alignof(T);
+		info._move = [](void* dst, void* src)
+		{
+			new (dst) T(std::move(*static_cast<T*>(src)));
+			static_cast<T*>(src)->~T();
+		};
+		info._destroy = [](void* component)
+		{
+			static_cast<T*>(component)->~T();
+		};
+		return info;
+	}
+};
+
+/*
+** All entities with exactly the same set of component types.
+**
+** Each type gets one contiguous column, and a row across the columns is one
+** entity. Rows are packed: removing one moves the last row into its place.
+*/
+class ga_archetype
+{
+public:
+	uint64_t get_signature() const { return _signature; }
+	int get_count() const { return _count; }
+	const ga_entity_id* get_entities() const { return _entities; }
+
+	bool has(int type) const { return (_signature & (uint64_t(1) << type)) != 0; }
+
+	/* Start of the column for a component type, or null if it's not here. */
+	void* get_column(int type) const { return has(type) ? _columns[_column_index[type]] : nullptr; }
+
+	template<class T>
+	T* get_column() const { return static_cast<T*>(get_column(ga_component_type<T>::get_id())); }
+
+private:
+	friend class ga_world;
+
+	ga_archetype(uint64_t signature);
+	~ga_archetype();
+
+	ga_archetype(const ga_archetype&) = delete;
+	ga_archetype& operator=(const ga_archetype&) = delete;
+
+	void* get_component(int type, int row) const;
+
+	// Adds an uninitialized row for the entity and returns its index.
+	int push(ga_entity_id entity);
+
+	// Destroys the row's components, fills the hole with the last row and
+	// returns the entity that moved, if any.
+	ga_entity_id erase(int row);
+
+	// Like erase, but assumes the row's components were already moved out.
+	ga_entity_id erase_moved(int row);
+
+	void grow();
+
+	uint64_t _signature;
+	int _count;
+	int _capacity;
+
+	ga_entity_id* _entities;
+	std::vector<int> _types;
+	std::vector<char*> _columns;
+	int _column_index[k_max_component_types];
+
+	// Archetypes one component type away, found once and then cached.
+	ga_archetype* _add_edges[k_max_component_types];
+	ga_archetype* _remove_edges[k_max_component_types];
+};
+
+/*
+** Entities as plain ids, with their components kept by type in archetypes.
+**
+** Work that reads a few component types iterates just those columns with
+** each(), instead of visiting every entity and virtual call in turn.
+** Adding or removing a component moves the entity's row to the archetype
+** for its new set of types, so do that between passes, not during one.
+**
+** Not thread safe for changes. Passes that write disjoint columns can run
+** at once.
+*/
+class ga_world
+{
+public:
+	ga_world();
+	~ga_world();
+
+	ga_world(const ga_world&) = delete;
+	ga_world& operator=(const ga_world&) = delete;
+
+	ga_entity_id create();
+	void destroy(ga_entity_id entity);
+	bool is_alive(ga_entity_id entity) const;
+
+	/* Adds a component, or replaces the one already there. */
+	template<class T>
+	T* add(ga_entity_id entity, T component)
+	{
+		int type = ga_component_type<T>::get_id();
+		void* slot = add_slot(entity, type);
+		if (!slot)
+		{
+			return nullptr;
+		}
+		return new (slot) T(std::move(component));
+	}
+
+	template<class T>
+	void remove(ga_entity_id entity)
+	{
+		remove_type(entity, ga_component_type<T>::get_id());
+	}
+
+	/* Null if the entity is dead or has no T. */
+	template<class T>
+	T* get(ga_entity_id entity) const
+	{
+		return static_cast<T*>(get_component(entity, ga_component_type<T>::get_id()));
+	}
+
+	/* Component mask for a set of types. */
+	template<class... Ts>
+	static uint64_t get_signature()
+	{
+		uint64_t bits[] = { 0, (uint64_t(1) << ga_component_type<Ts>::get_id())... };
+		uint64_t signature = 0;
+		for (uint64_t bit : bits)
+		{
+			signature |= bit;
+		}
+		return signature;
+	}
+
+	/*
+	** Calls func(count, entities, Ts* columns...) once for each non-empty
+	** archetype that has all of Ts.
+	*/
+	template<class... Ts, class F>
+	void each_archetype(F func) const
+	{
+		uint64_t signature = get_signature<Ts...>();
+		for (ga_archetype* archetype : _archetype_list)
+		{
+			if ((archetype->_signature & signature) == signature && archetype->_count > 0)
+			{
+				func(archetype->_count, archetype->_entities, archetype->get_column<Ts>()...);
+			}
+		}
+	}
+
+	/* Calls func(entity, Ts&...) for every entity that has all of Ts. */
+	template<class... Ts, class F>
+	void each(F func) const
+	{
+		each_archetype<Ts...>(each_row_t<F, Ts...>(func));
+	}
+
+	/* Archetypes in the order they were created. */
+	const std::vector<ga_archetype*>& get_archetypes() const { return _archetype_list; }
+
+	int get_entity_count() const { return _entity_count; }
+
+private:
+	template<class F, class... Ts>
+	struct each_row_t
+	{
+		each_row_t(F& func) : _func(func) {}
+
+		void operator()(int count, const ga_entity_id* entities, Ts*... columns) const
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				_func(entities[i], columns[i]...);
+			}
+		}
+
+		F& _func;
+	};
+
+	struct record_t
+	{
+		ga_archetype* _archetype;
+		int _row;
+		uint32_t _generation;
+	};
+
+	const record_t* get_record(ga_entity_id entity) const;
+	ga_archetype* get_archetype(uint64_t signature);
+
+	void* get_component(ga_entity_id entity, int type) const;
+
+	// Moves the entity to its archetype with type added and returns the
+	// uninitialized slot, or the existing component destroyed for reuse.
+	void* add_slot(ga_entity_id entity, int type);
+	void remove_type(ga_entity_id entity, int type);
+
+	void move_entity(record_t* record, ga_archetype* to);
+
+	std::vector<record_t> _records;
+	std::vector<uint32_t> _free_records;
+	int _entity_count;
+
+	std::unordered_map<uint64_t, ga_archetype*> _archetypes;
+	std::vector<ga_archetype*> _archetype_list;
+};
@@ -0,0 +1,62 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_alloc_count.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if GA_COUNT_ALLOCS
+
+// Constant-initialized, so it's ready for allocations made during static init.
+static std::atomic<uint64_t> g_heap_alloc_count(0);
+
+uint64_t ga_get_heap_alloc_count()
+{
+	return g_heap_alloc_count.load(std::memory_order_relaxed);
+}
+
+// Replace the global allocation functions to count calls. The array forms
+// forward to these by default.
+void* operator new(size_t size)
+{
+	g_heap_alloc_count.fetch_add(1, std::memory_order_relaxed);
+	void* p = malloc(size ? size : 1);
+	if (!p)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	g_heap_alloc_count.fetch_add(1, std::memory_order_relaxed);
+	return malloc(size ? size : 1);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	free(p);
+}
+
+#else
+
+uint64_t ga_get_heap_alloc_count()
+{
+	return 0;
+}
+
+#endif
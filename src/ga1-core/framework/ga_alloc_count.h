@@ -0,0 +1,29 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include <cstdint>
+
+/*
+** Set to 1 to count heap allocations. Counting replaces the global
+** operator new, and every allocation then touches one shared counter, so
+** it's only for benchmark and verification builds.
+*/
+#if !defined(GA_COUNT_ALLOCS)
+#define GA_COUNT_ALLOCS 0
+#endif
+
+/*
+** Heap allocations made through operator new so far, on every thread.
+** Sample before and after a stretch of work to see whether it allocated.
+** Anything calling malloc directly, like SDL or Lua, isn't counted.
+** Always 0 unless GA_COUNT_ALLOCS is set.
+*/
+uint64_t ga_get_heap_alloc_count();
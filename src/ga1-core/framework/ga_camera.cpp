@@ -10,6 +10,8 @@
 #include "ga_camera.h"
 
 #include "ga_frame_params.h"
+#include "ga_input_ring.h"
+#include "ga_profiler.h"
 #include "math/ga_math.h"
 
 ga_camera::ga_camera(const ga_vec3f& eye)
@@ -23,17 +25,36 @@ ga_camera::~ga_camera()
 
 void ga_camera::update(ga_frame_params* params)
 {
+	GA_PROFILE_SCOPE("camera");
+
 	const float k_move_speed = 0.1f;
 	const float k_rotate_speed = 0.5f;
 
+	// How much of the frame each key was held, from the input events, so a
+	// tap or a release partway through the frame moves only that far.
+	auto held = [params](uint64_t button)
+	{
+		auto window = params->_current_time - params->_input_begin_time;
+		if (!params->_input_events || window <= std::chrono::high_resolution_clock::duration::zero())
+		{
+			return (params->_button_mask & button) ? 1.0f : 0.0f;
+		}
+
+		auto time = params->_input_events->get_held_time(
+			params->_input_event_begin,
+			params->_input_event_end,
+			button,
+			params->_button_mask,
+			params->_input_begin_time,
+			params->_current_time);
+		return float(std::chrono::duration<double>(time).count() / std::chrono::duration<double>(window).count());
+	};
+
 	// Use WASD to control the position.
 	ga_vec3f translation = { 0.0f, 0.0f, 0.0f };
-	translation += (params->_button_mask & k_button_d) ? -_transform.get_right() : ga_vec3f::zero_vector();
-	translation += (params->_button_mask & k_button_a) ? _transform.get_right() : ga_vec3f::zero_vector();
-	translation += (params->_button_mask & k_button_s) ? -_transform.get_forward() : ga_vec3f::zero_vector();
-	translation += (params->_button_mask & k_button_w) ? _transform.get_forward() : ga_vec3f::zero_vector();
-	translation += (params->_button_mask & k_button_q) ? -_transform.get_up() : ga_vec3f::zero_vector();
-	translation += (params->_button_mask & k_button_e) ? _transform.get_up() : ga_vec3f::zero_vector();
+	translation += _transform.get_right().scale_result(held(k_button_a) - held(k_button_d));
+	translation += _transform.get_forward().scale_result(held(k_button_w) - held(k_button_s));
+	translation += _transform.get_up().scale_result(held(k_button_e) - held(k_button_q));
 	translation.scale(k_move_speed);
 
 	// By using the camera's directional vectors, we've defined the translation in world space.
@@ -42,12 +63,8 @@ void ga_camera::update(ga_frame_params* params)
 	_transform = _transform * world_translation;
 
 	// Use arrow keys to pitch and rotate.
-	float rotation = 0.0f;
-	rotation += (params->_button_mask & k_button_left) ? k_rotate_speed : 0.0f;
-	rotation += (params->_button_mask & k_button_right) ? -k_rotate_speed : 0.0f;
-	float pitch = 0.0f;
-	pitch += (params->_button_mask & k_button_up) ? -k_rotate_speed : 0.0f;
-	pitch += (params->_button_mask & k_button_down) ? k_rotate_speed : 0.0f;
+	float rotation = k_rotate_speed * (held(k_button_left) - held(k_button_right));
+	float pitch = k_rotate_speed * (held(k_button_down) - held(k_button_up));
 
 	rotation = ga_degrees_to_radians(rotation);
 	pitch = ga_degrees_to_radians(pitch);
@@ -14,6 +14,13 @@
 #define GA_MSVC
 #elif defined(__MINGW32__)
 #define GA_MINGW
+#elif defined(__GNUC__)
+#define GA_GCC
+#endif
+
+// Platforms.
+#if defined(__linux__)
+#define GA_LINUX
 #endif
 
 // Architecture.
@@ -28,3 +35,11 @@
 #if defined(__MINGW32__)
 #define GA_32_BIT
 #endif
+
+#if defined(GA_GCC)
+#if defined(__LP64__)
+#define GA_64_BIT
+#else
+#define GA_32_BIT
+#endif
+#endif
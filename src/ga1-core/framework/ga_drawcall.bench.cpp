@@ -0,0 +1,123 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+/*
+** Drawcall emission benchmark.
+** A parallel_for across every core emits 100k static drawcalls per frame,
+** once into a single vector behind a spin lock, as the frame params used to,
+** and once into per-thread ga_drawcall_list buckets.
+*/
+
+#include "ga_drawcall.h"
+#include "ga_drawcall_list.h"
+
+#include "jobs/ga_frame_arena.h"
+#include "jobs/ga_job.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+
+typedef std::chrono::high_resolution_clock ga_bench_clock_t;
+
+static const int k_emit_count = 100000;
+static const int k_emit_grain = 256;
+static const int k_frame_count = 50;
+
+struct locked_list_t
+{
+	locked_list_t(ga_frame_arena* arena) : _drawcalls(arena) {}
+
+	ga_frame_vector<ga_static_drawcall> _drawcalls;
+	std::atomic_flag _lock = ATOMIC_FLAG_INIT;
+};
+
+static void make_drawcall(int index, ga_static_drawcall* draw)
+{
+	for (int r = 0; r < 4; ++r)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			draw->_transform.data[r][c] = r == c ? 1.0f : 0.0f;
+		}
+	}
+	draw->_transform.data[3][0] = float(index);
+	draw->_draw_mode = GL_TRIANGLES;
+	draw->_vao = GLuint(index);
+	draw->_index_count = 36;
+	draw->_material = nullptr;
+}
+
+static void emit_locked(int begin, int end, void* data)
+{
+	locked_list_t* list = static_cast<locked_list_t*>(data);
+	for (int i = begin; i < end; ++i)
+	{
+		ga_static_drawcall draw;
+		make_drawcall(i, &draw);
+
+		while (list->_lock.test_and_set(std::memory_order_acquire)) {}
+		list->_drawcalls.push_back(std::move(draw));
+		list->_lock.clear(std::memory_order_release);
+	}
+}
+
+static void emit_buckets(int begin, int end, void* data)
+{
+	ga_drawcall_list<ga_static_drawcall>* list = static_cast<ga_drawcall_list<ga_static_drawcall>*>(data);
+	for (int i = begin; i < end; ++i)
+	{
+		ga_static_drawcall draw;
+		make_drawcall(i, &draw);
+		list->push_back(std::move(draw));
+	}
+}
+
+template<class T>
+static double run_frames(ga_frame_arena* arena, ga_job_range_function_t func)
+{
+	double total = 0.0;
+	for (int f = 0; f < k_frame_count; ++f)
+	{
+		{
+			T list(arena);
+
+			auto t0 = ga_bench_clock_t::now();
+			ga_job::parallel_for(0, k_emit_count, k_emit_grain, func, &list);
+			auto t1 = ga_bench_clock_t::now();
+
+			total += std::chrono::duration<double, std::milli>(t1 - t0).count();
+		}
+		arena->reset();
+	}
+	return total / k_frame_count;
+}
+
+int main(int argc, const char** argv)
+{
+	ga_job::startup(ga_job_config());
+
+	ga_frame_arena arena(16 << 20);
+
+	/* One untimed pass each so the arena has grown to fit. */
+	run_frames<locked_list_t>(&arena, emit_locked);
+	run_frames<ga_drawcall_list<ga_static_drawcall>>(&arena, emit_buckets);
+
+	double locked = run_frames<locked_list_t>(&arena, emit_locked);
+	double buckets = run_frames<ga_drawcall_list<ga_static_drawcall>>(&arena, emit_buckets);
+
+	printf("%d drawcalls per frame, %d threads, mean of %d frames\n", k_emit_count, ga_job::get_thread_count(), k_frame_count);
+	printf("%16s %10.3f ms %10.2f Memit/s\n", "spin lock", locked, k_emit_count / locked / 1e3);
+	printf("%16s %10.3f ms %10.2f Memit/s\n", "thread buckets", buckets, k_emit_count / buckets / 1e3);
+
+	ga_job::shutdown();
+
+	return 0;
+}
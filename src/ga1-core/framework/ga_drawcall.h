@@ -9,13 +9,12 @@
 ** This file is distributed under the MIT License. See LICENSE.txt.
 */
 
+#include "ga_name.h"
+#include "jobs/ga_frame_arena.h"
 #include "math/ga_mat4f.h"
 #include "math/ga_vec2f.h"
 #include "math/ga_vec3f.h"
 
-#include <string>
-#include <vector>
-
 #define GLEW_STATIC
 #include <GL/glew.h>
 
@@ -25,7 +24,7 @@
 */
 struct ga_drawcall
 {
-	std::string _name;
+	ga_name_t _name = 0;
 	ga_mat4f _transform;
 	GLenum _draw_mode;
 	class ga_material* _material = 0;
@@ -40,16 +39,29 @@ struct ga_static_drawcall : ga_drawcall
 {
 	GLuint _vao;
 	GLsizei _index_count;
+
+	// Skinning matrices captured when the draw was emitted, in frame memory.
+	const ga_mat4f* _skin = 0;
+	uint32_t _skin_count = 0;
 };
 
 /*
 ** Draw call with dynamic geometry.
 ** Geometry referenced by this draw call should only a single frame.
+** Its vertices and indices live in the frame's arena; reserve up front where
+** the size is known, since growing leaves the old storage behind.
 */
 struct ga_dynamic_drawcall : ga_drawcall
 {
-	std::vector<ga_vec3f> _positions;
-	std::vector<ga_vec2f> _texcoords;
-	std::vector<uint16_t> _indices;
+	ga_dynamic_drawcall(ga_frame_arena* arena) :
+		_positions(arena),
+		_texcoords(arena),
+		_indices(arena)
+	{
+	}
+
+	ga_frame_vector<ga_vec3f> _positions;
+	ga_frame_vector<ga_vec2f> _texcoords;
+	ga_frame_vector<uint16_t> _indices;
 	ga_vec3f _color;
 };
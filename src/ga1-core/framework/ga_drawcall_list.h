@@ -0,0 +1,94 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "jobs/ga_frame_arena.h"
+#include "jobs/ga_job.h"
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+/*
+** Drawcalls emitted during a frame, kept in one bucket per job thread.
+**
+** Each thread appends only to its own bucket, so emitting takes no lock and
+** threads don't fight over a cache line. Order within a bucket is emission
+** order; order across buckets is whatever the scheduler made it.
+**
+** Emit only from jobs and the main thread. Any other thread, like an I/O
+** thread, would share the main thread's bucket with it unchecked; debug
+** builds assert on that. Read only once every emitter is done, such as
+** after waiting on the sim.
+*/
+template<class T>
+class ga_drawcall_list
+{
+public:
+	typedef ga_frame_vector<T> bucket_t;
+
+	ga_drawcall_list(ga_frame_arena* arena)
+	{
+		_bucket_count = ga_job::get_thread_count();
+		_buckets = static_cast<padded_bucket_t*>(arena->alloc(sizeof(padded_bucket_t) * _bucket_count, alignof(padded_bucket_t)));
+		for (int i = 0; i < _bucket_count; ++i)
+		{
+			new (&_buckets[i]) padded_bucket_t(arena);
+		}
+	}
+
+	~ga_drawcall_list()
+	{
+		for (int i = 0; i < _bucket_count; ++i)
+		{
+			_buckets[i].~padded_bucket_t();
+		}
+	}
+
+	ga_drawcall_list(const ga_drawcall_list&) = delete;
+	ga_drawcall_list& operator=(const ga_drawcall_list&) = delete;
+
+	void push_back(const T& drawcall)
+	{
+		assert(ga_job::is_job_thread());
+		_buckets[ga_job::get_thread_index()]._drawcalls.push_back(drawcall);
+	}
+
+	void push_back(T&& drawcall)
+	{
+		assert(ga_job::is_job_thread());
+		_buckets[ga_job::get_thread_index()]._drawcalls.push_back(std::move(drawcall));
+	}
+
+	int get_bucket_count() const { return _bucket_count; }
+	const bucket_t& get_bucket(int index) const { return _buckets[index]._drawcalls; }
+
+	size_t size() const
+	{
+		size_t count = 0;
+		for (int i = 0; i < _bucket_count; ++i)
+		{
+			count += _buckets[i]._drawcalls.size();
+		}
+		return count;
+	}
+
+private:
+	/* Keep neighboring threads' vector headers off each other's cache lines. */
+	struct alignas(64) padded_bucket_t
+	{
+		padded_bucket_t(ga_frame_arena* arena) : _drawcalls(arena) {}
+		bucket_t _drawcalls;
+	};
+
+	padded_bucket_t* _buckets;
+	int _bucket_count;
+};
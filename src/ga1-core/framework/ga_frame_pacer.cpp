@@ -0,0 +1,223 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_frame_pacer.h"
+#include "ga_compiler_defines.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(GA_MINGW)
+#include <unistd.h>
+#else
+#include <thread>
+#endif
+
+#if defined(GA_MSVC)
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// Bounds on how early to stop sleeping, and extra slack for late latch.
+static const std::chrono::microseconds k_min_spin_margin(250);
+static const std::chrono::microseconds k_max_spin_margin(4000);
+static const std::chrono::microseconds k_late_latch_slack(500);
+
+ga_frame_pacer::ga_frame_pacer(int target_rate, bool late_latch) :
+	_late_latch(late_latch),
+	_poll(nullptr),
+	_poll_data(nullptr),
+	_started(false),
+	_work_count(0),
+	_spin_margin(std::chrono::milliseconds(2)),
+	_presents(0),
+	_interval_sum(0.0),
+	_interval_sum_sq(0.0),
+	_min_interval(0.0),
+	_max_interval(0.0),
+	_sleep_time(pacer_clock_t::duration::zero()),
+	_spin_time(pacer_clock_t::duration::zero())
+{
+	set_target_rate(target_rate);
+
+#if defined(GA_MSVC)
+	// The default scheduler tick is ~15ms, far coarser than a frame.
+	timeBeginPeriod(1);
+#endif
+}
+
+ga_frame_pacer::~ga_frame_pacer()
+{
+#if defined(GA_MSVC)
+	timeEndPeriod(1);
+#endif
+}
+
+void ga_frame_pacer::set_target_rate(int target_rate)
+{
+	_period = target_rate > 0 ?
+		std::chrono::duration_cast<pacer_clock_t::duration>(std::chrono::duration<double>(1.0 / target_rate)) :
+		pacer_clock_t::duration::zero();
+}
+
+void ga_frame_pacer::set_late_latch(bool late_latch)
+{
+	_late_latch = late_latch;
+}
+
+void ga_frame_pacer::set_poll(ga_frame_pacer_poll_t poll, void* data, std::chrono::microseconds interval)
+{
+	_poll = poll;
+	_poll_data = data;
+	_poll_interval = interval;
+}
+
+void ga_frame_pacer::wait()
+{
+	if (!_started || _period == pacer_clock_t::duration::zero())
+	{
+		_frame_start = pacer_clock_t::now();
+		_next_deadline = _frame_start + _period;
+		_started = true;
+		return;
+	}
+
+	// With late latch, start just early enough for the work to finish by
+	// the next present.
+	pacer_clock_t::time_point deadline = _next_deadline;
+	if (_late_latch && _presents > 0)
+	{
+		deadline = _next_present - get_work_estimate();
+	}
+
+	wait_until(deadline);
+	_frame_start = pacer_clock_t::now();
+
+	// Keep frames on a fixed schedule, unless we've fallen a whole period
+	// behind, in which case restart it rather than rush to catch up.
+	_next_deadline = (_frame_start - deadline > _period ? _frame_start : deadline) + _period;
+}
+
+void ga_frame_pacer::mark_present()
+{
+	pacer_clock_t::time_point now = pacer_clock_t::now();
+
+	if (_presents > 0)
+	{
+		double interval = std::chrono::duration<double, std::milli>(now - _last_present).count();
+		_interval_sum += interval;
+		_interval_sum_sq += interval * interval;
+		_min_interval = _presents == 1 ? interval : std::min(_min_interval, interval);
+		_max_interval = _presents == 1 ? interval : std::max(_max_interval, interval);
+	}
+
+	if (_started)
+	{
+		_work[_work_count % k_work_history] = now - _frame_start;
+		_work_count++;
+	}
+
+	// Presents early by however much the estimate was over, so schedule
+	// from the target rather than the present itself. Same catch-up rule
+	// as frame starts.
+	bool behind = _presents == 0 || now - _next_present > _period;
+	_next_present = (behind ? now : _next_present) + _period;
+
+	_last_present = now;
+	_presents++;
+}
+
+ga_frame_pacer_stats ga_frame_pacer::get_stats() const
+{
+	ga_frame_pacer_stats stats;
+	stats._presents = _presents;
+
+	int intervals = _presents - 1;
+	if (intervals > 0)
+	{
+		double mean = _interval_sum / intervals;
+		double variance = _interval_sum_sq / intervals - mean * mean;
+		stats._mean_interval = std::chrono::duration<double, std::milli>(mean);
+		stats._min_interval = std::chrono::duration<double, std::milli>(_min_interval);
+		stats._max_interval = std::chrono::duration<double, std::milli>(_max_interval);
+		stats._interval_deviation = std::chrono::duration<double, std::milli>(std::sqrt(std::max(variance, 0.0)));
+	}
+	else
+	{
+		stats._mean_interval = stats._min_interval = stats._max_interval = stats._interval_deviation =
+			std::chrono::duration<double, std::milli>::zero();
+	}
+
+	stats._sleep_time = _sleep_time;
+	stats._spin_time = _spin_time;
+	return stats;
+}
+
+void ga_frame_pacer::wait_until(pacer_clock_t::time_point deadline)
+{
+	pacer_clock_t::duration slept = pacer_clock_t::duration::zero();
+	pacer_clock_t::time_point start = pacer_clock_t::now();
+
+	for (pacer_clock_t::time_point now = start; now < deadline; now = pacer_clock_t::now())
+	{
+		if (_poll)
+		{
+			_poll(_poll_data);
+			now = pacer_clock_t::now();
+			if (now >= deadline)
+			{
+				break;
+			}
+		}
+
+		pacer_clock_t::duration remaining = deadline - now;
+		if (remaining <= _spin_margin)
+		{
+#if !defined(GA_MINGW)
+			std::this_thread::yield();
+#endif
+			continue;
+		}
+
+		pacer_clock_t::duration request = remaining - _spin_margin;
+		if (_poll && request > _poll_interval)
+		{
+			request = _poll_interval;
+		}
+#if defined(GA_MINGW)
+		usleep(uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(request).count()));
+#else
+		std::this_thread::sleep_for(request);
+#endif
+		pacer_clock_t::duration actual = pacer_clock_t::now() - now;
+		slept += actual;
+
+		// Keep the margin near twice the worst recent oversleep. Grow at once
+		// so the next deadline isn't missed; shrink slowly.
+		pacer_clock_t::duration target = std::max<pacer_clock_t::duration>(2 * (actual - request), k_min_spin_margin);
+		target = std::min<pacer_clock_t::duration>(target, k_max_spin_margin);
+		_spin_margin = target > _spin_margin ? target : _spin_margin - (_spin_margin - target) / 16;
+	}
+
+	_sleep_time += slept;
+	_spin_time += (pacer_clock_t::now() - start) - slept;
+}
+
+ga_frame_pacer::pacer_clock_t::duration ga_frame_pacer::get_work_estimate() const
+{
+	// The slowest recent frame, so one slow frame doesn't miss its present.
+	int count = std::min<int>(_work_count, k_work_history);
+	pacer_clock_t::duration work = pacer_clock_t::duration::zero();
+	for (int i = 0; i < count; ++i)
+	{
+		work = std::max(work, _work[i]);
+	}
+	return work + k_late_latch_slack;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include <chrono>
+#include <cstdint>
+
+/*
+** Present intervals and time spent waiting, since the pacer was created.
+*/
+struct ga_frame_pacer_stats
+{
+	int _presents = 0;
+
+	std::chrono::duration<double, std::milli> _mean_interval;
+	std::chrono::duration<double, std::milli> _min_interval;
+	std::chrono::duration<double, std::milli> _max_interval;
+	std::chrono::duration<double, std::milli> _interval_deviation;
+
+	std::chrono::duration<double, std::milli> _sleep_time;
+	std::chrono::duration<double, std::milli> _spin_time;
+};
+
+/* Called over and over while the pacer waits. */
+typedef void (*ga_frame_pacer_poll_t)(void* data);
+
+/*
+** Holds the main loop to a target frame rate.
+**
+** wait() sleeps while the deadline is far off and spins for the last
+** stretch, since sleeps overshoot. The spin margin tracks how late sleeps
+** have actually woken.
+**
+** Normally frames start one period apart. In late-latch mode the pacer
+** instead aims for presents one period apart. It starts each frame as late
+** as its recent work time allows, so input is sampled just before the
+** frame is submitted. That pays off with vsync, where the present can't
+** happen any sooner and starting early only ages the input.
+**
+** With a poll function set, the wait sleeps in slices no longer than the
+** poll interval and calls it between them, so input keeps being read
+** while the loop is idle.
+*/
+class ga_frame_pacer
+{
+public:
+	/* A rate of 0 doesn't wait at all, but still measures. */
+	ga_frame_pacer(int target_rate = 60, bool late_latch = false);
+	~ga_frame_pacer();
+
+	void set_target_rate(int target_rate);
+	void set_late_latch(bool late_latch);
+	void set_poll(ga_frame_pacer_poll_t poll, void* data, std::chrono::microseconds interval = std::chrono::microseconds(1000));
+
+	/* Returns once the next frame should start. Call before sampling input. */
+	void wait();
+
+	/* Call right after the frame is presented. */
+	void mark_present();
+
+	ga_frame_pacer_stats get_stats() const;
+
+private:
+	typedef std::chrono::high_resolution_clock pacer_clock_t;
+
+	void wait_until(pacer_clock_t::time_point deadline);
+	pacer_clock_t::duration get_work_estimate() const;
+
+	pacer_clock_t::duration _period;
+	bool _late_latch;
+
+	ga_frame_pacer_poll_t _poll;
+	void* _poll_data;
+	pacer_clock_t::duration _poll_interval;
+
+	// When the last frame started, and when the next is due to start or,
+	// with late latch, to present.
+	pacer_clock_t::time_point _frame_start;
+	pacer_clock_t::time_point _next_deadline;
+	pacer_clock_t::time_point _next_present;
+	bool _started;
+
+	// Start-to-present time of recent frames, for late latch.
+	enum { k_work_history = 16 };
+	pacer_clock_t::duration _work[k_work_history];
+	int _work_count;
+
+	// How long before a deadline to stop sleeping and spin.
+	pacer_clock_t::duration _spin_margin;
+
+	pacer_clock_t::time_point _last_present;
+	int _presents;
+	double _interval_sum;
+	double _interval_sum_sq;
+	double _min_interval;
+	double _max_interval;
+
+	pacer_clock_t::duration _sleep_time;
+	pacer_clock_t::duration _spin_time;
+};
@@ -10,9 +10,10 @@
 */
 
 #include "ga_drawcall.h"
+#include "ga_drawcall_list.h"
+#include "jobs/ga_frame_arena.h"
 #include "math/ga_mat4f.h"
 
-#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <vector>
@@ -61,6 +62,20 @@ enum ga_button_t
 */
 struct ga_frame_params
 {
+	// Containers allocate from the arena, which must outlive these params
+	// and is reset once they're gone.
+	ga_frame_params(ga_frame_arena* arena) :
+		_arena(arena),
+		_static_drawcalls(arena),
+		_dynamic_drawcalls(arena),
+		_gui_drawcalls(arena)
+	{
+	}
+
+	// Memory for anything the sim captures for output. Lives as long as
+	// these params, which may be after the sim has moved on to the next frame.
+	ga_frame_arena* _arena;
+
 	// Data emitted by input stage:
 	std::chrono::high_resolution_clock::time_point _current_time;
 	std::chrono::high_resolution_clock::duration _delta_time;
@@ -72,15 +87,18 @@ struct ga_frame_params
 	float _mouse_x;
 	float _mouse_y;
 
-	// Data emitted by sim stage:
-	std::vector<ga_static_drawcall> _static_drawcalls;
-	std::atomic_flag _static_drawcall_lock = ATOMIC_FLAG_INIT;
-
-	std::vector<ga_dynamic_drawcall> _dynamic_drawcalls;
-	std::atomic_flag _dynamic_drawcall_lock = ATOMIC_FLAG_INIT;
+	// Input events polled since the last frame, in [begin, end), and the
+	// time the frame's input window opened. A stage sampling later can read
+	// on past end, up to the ring's head.
+	const class ga_input_ring* _input_events = nullptr;
+	uint64_t _input_event_begin = 0;
+	uint64_t _input_event_end = 0;
+	std::chrono::high_resolution_clock::time_point _input_begin_time;
 
-	std::vector<ga_dynamic_drawcall> _gui_drawcalls;
-	std::atomic_flag _gui_drawcall_lock = ATOMIC_FLAG_INIT;
+	// Data emitted by sim stage. Each job thread appends to its own bucket.
+	ga_drawcall_list<ga_static_drawcall> _static_drawcalls;
+	ga_drawcall_list<ga_dynamic_drawcall> _dynamic_drawcalls;
+	ga_drawcall_list<ga_dynamic_drawcall> _gui_drawcalls;
 
 	ga_mat4f _view;
 
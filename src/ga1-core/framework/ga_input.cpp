@@ -10,21 +10,19 @@
 #include "ga_input.h"
 #include "ga_compiler_defines.h"
 #include "ga_frame_params.h"
+#include "ga_input_log.h"
+#include "ga_profiler.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
-#if defined(GA_MINGW)
-#include <unistd.h>
-#else
-#include <thread>
-#endif
 
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 #define GLEW_STATIC
 #include <GL/glew.h>
 
-ga_input::ga_input() : _paused(false)
+ga_input::ga_input() : _frame_event(0), _recorder(nullptr), _player(nullptr), _paused(false), _quit(false)
 {
 	SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_TIMER);
 
@@ -64,10 +62,14 @@ ga_input::ga_input() : _paused(false)
 	}
 
 	_button_mask = 0;
+	_pressed_mask = 0;
+	_released_mask = 0;
 	_mouse_button_mask = 0;
+	_mouse_click_mask = 0;
 	_mouse_x = 0.0f;
 	_mouse_y = 0.0f;
 	_last_time = std::chrono::high_resolution_clock::now();
+	_last_event_time = _last_time;
 }
 
 ga_input::~ga_input()
@@ -76,145 +78,157 @@ ga_input::~ga_input()
 	SDL_Quit();
 }
 
-bool ga_input::update(ga_frame_params* params)
+static uint64_t get_button(SDL_Keycode key)
 {
-	bool result = true;
+	switch (key)
+	{
+	case SDLK_LEFT: return k_button_left;
+	case SDLK_RIGHT: return k_button_right;
+	case SDLK_UP: return k_button_up;
+	case SDLK_DOWN: return k_button_down;
+	case SDLK_SPACE: return k_button_space;
+	case SDLK_a: return k_button_a;
+	case SDLK_b: return k_button_b;
+	case SDLK_c: return k_button_c;
+	case SDLK_d: return k_button_d;
+	case SDLK_e: return k_button_e;
+	case SDLK_f: return k_button_f;
+	case SDLK_g: return k_button_g;
+	case SDLK_h: return k_button_h;
+	case SDLK_i: return k_button_i;
+	case SDLK_j: return k_button_j;
+	case SDLK_k: return k_button_k;
+	case SDLK_l: return k_button_l;
+	case SDLK_m: return k_button_m;
+	case SDLK_n: return k_button_n;
+	case SDLK_o: return k_button_o;
+	case SDLK_p: return k_button_p;
+	case SDLK_q: return k_button_q;
+	case SDLK_r: return k_button_r;
+	case SDLK_s: return k_button_s;
+	case SDLK_t: return k_button_t;
+	case SDLK_u: return k_button_u;
+	case SDLK_v: return k_button_v;
+	case SDLK_w: return k_button_w;
+	case SDLK_x: return k_button_x;
+	case SDLK_y: return k_button_y;
+	case SDLK_z: return k_button_z;
+	default: return 0;
+	}
+}
 
-	// Save the previous frame's button mask to computed released keys.
-	uint64_t previous_button_mask = _button_mask;
-	params->_mouse_click_mask = 0;
+void ga_input::poll()
+{
+	auto now = std::chrono::high_resolution_clock::now();
+	uint32_t ticks = SDL_GetTicks();
 
 	// Process events. Gather button status.
 	SDL_Event event;
 	while (SDL_PollEvent(&event))
 	{
+		ga_input_event input_event;
+
 		switch (event.type)
 		{
 		case SDL_MOUSEMOTION:
 			_mouse_x = (float)event.motion.x;
 			_mouse_y = (float)event.motion.y;
+			input_event._type = k_input_mouse_move;
+			input_event._button = 0;
+			input_event._mask = _mouse_button_mask;
 			break;
 		case SDL_MOUSEBUTTONDOWN:
 			_mouse_button_mask |= uint64_t(1) << event.button.button;
+			input_event._type = k_input_mouse_down;
+			input_event._button = uint64_t(1) << event.button.button;
+			input_event._mask = _mouse_button_mask;
 			break;
 		case SDL_MOUSEBUTTONUP:
 			_mouse_button_mask &= ~(uint64_t(1) << event.button.button);
-			params->_mouse_click_mask |= uint64_t(1) << event.button.button;
+			_mouse_click_mask |= uint64_t(1) << event.button.button;
+			input_event._type = k_input_mouse_up;
+			input_event._button = uint64_t(1) << event.button.button;
+			input_event._mask = _mouse_button_mask;
 			break;
 		case SDL_KEYDOWN:
-			switch (event.key.keysym.sym)
+		case SDL_KEYUP:
+			input_event._button = get_button(event.key.keysym.sym);
+			if (!input_event._button || event.key.repeat)
 			{
-			case SDLK_LEFT: _button_mask |= k_button_left; break;
-			case SDLK_RIGHT: _button_mask |= k_button_right; break;
-			case SDLK_UP: _button_mask |= k_button_up; break;
-			case SDLK_DOWN: _button_mask |= k_button_down; break;
-			case SDLK_SPACE: _button_mask |= k_button_space; break;
-			case SDLK_a: _button_mask |= k_button_a; break;
-			case SDLK_b: _button_mask |= k_button_b; break;
-			case SDLK_c: _button_mask |= k_button_c; break;
-			case SDLK_d: _button_mask |= k_button_d; break;
-			case SDLK_e: _button_mask |= k_button_e; break;
-			case SDLK_f: _button_mask |= k_button_f; break;
-			case SDLK_g: _button_mask |= k_button_g; break;
-			case SDLK_h: _button_mask |= k_button_h; break;
-			case SDLK_i: _button_mask |= k_button_i; break;
-			case SDLK_j: _button_mask |= k_button_j; break;
-			case SDLK_k: _button_mask |= k_button_k; break;
-			case SDLK_l: _button_mask |= k_button_l; break;
-			case SDLK_m: _button_mask |= k_button_m; break;
-			case SDLK_n: _button_mask |= k_button_n; break;
-			case SDLK_o: _button_mask |= k_button_o; break;
-			case SDLK_p: _button_mask |= k_button_p; break;
-			case SDLK_q: _button_mask |= k_button_q; break;
-			case SDLK_r: _button_mask |= k_button_r; break;
-			case SDLK_s: _button_mask |= k_button_s; break;
-			case SDLK_t: _button_mask |= k_button_t; break;
-			case SDLK_u: _button_mask |= k_button_u; break;
-			case SDLK_v: _button_mask |= k_button_v; break;
-			case SDLK_w: _button_mask |= k_button_w; break;
-			case SDLK_x: _button_mask |= k_button_x; break;
-			case SDLK_y: _button_mask |= k_button_y; break;
-			case SDLK_z: _button_mask |= k_button_z; break;
-			default: break;
+				continue;
 			}
-			break;
-		case SDL_KEYUP:
-			switch (event.key.keysym.sym)
+			if (event.type == SDL_KEYDOWN)
 			{
-			case SDLK_LEFT: _button_mask &= ~k_button_left; break;
-			case SDLK_RIGHT: _button_mask &= ~k_button_right; break;
-			case SDLK_UP: _button_mask &= ~k_button_up; break;
-			case SDLK_DOWN: _button_mask &= ~k_button_down; break;
-			case SDLK_SPACE: _button_mask &= ~k_button_space; break;
-			case SDLK_a: _button_mask &= ~k_button_a; break;
-			case SDLK_b: _button_mask &= ~k_button_b; break;
-			case SDLK_c: _button_mask &= ~k_button_c; break;
-			case SDLK_d: _button_mask &= ~k_button_d; break;
-			case SDLK_e: _button_mask &= ~k_button_e; break;
-			case SDLK_f: _button_mask &= ~k_button_f; break;
-			case SDLK_g: _button_mask &= ~k_button_g; break;
-			case SDLK_h: _button_mask &= ~k_button_h; break;
-			case SDLK_i: _button_mask &= ~k_button_i; break;
-			case SDLK_j: _button_mask &= ~k_button_j; break;
-			case SDLK_k: _button_mask &= ~k_button_k; break;
-			case SDLK_l: _button_mask &= ~k_button_l; break;
-			case SDLK_m: _button_mask &= ~k_button_m; break;
-			case SDLK_n: _button_mask &= ~k_button_n; break;
-			case SDLK_o: _button_mask &= ~k_button_o; break;
-			case SDLK_p: _button_mask &= ~k_button_p; break;
-			case SDLK_q: _button_mask &= ~k_button_q; break;
-			case SDLK_r: _button_mask &= ~k_button_r; break;
-			case SDLK_s: _button_mask &= ~k_button_s; break;
-			case SDLK_t: _button_mask &= ~k_button_t; break;
-			case SDLK_u: _button_mask &= ~k_button_u; break;
-			case SDLK_v: _button_mask &= ~k_button_v; break;
-			case SDLK_w: _button_mask &= ~k_button_w; break;
-			case SDLK_x: _button_mask &= ~k_button_x; break;
-			case SDLK_y: _button_mask &= ~k_button_y; break;
-			case SDLK_z: _button_mask &= ~k_button_z; break;
-			default: break;
+				_button_mask |= input_event._button;
+				_pressed_mask |= input_event._button;
+				input_event._type = k_input_key_down;
 			}
+			else
+			{
+				_button_mask &= ~input_event._button;
+				_released_mask |= input_event._button;
+				input_event._type = k_input_key_up;
+			}
+			input_event._mask = _button_mask;
 			break;
 		case SDL_QUIT:
-			result = false;
-			break;
+			_quit = true;
+			continue;
 		default:
-			break;
+			continue;
 		}
+
+		// SDL stamps events in milliseconds as they're queued, which may be
+		// well before this poll if the frame kept us busy. Keep stamps in order.
+		auto age = std::chrono::milliseconds(ticks - std::min(event.common.timestamp, ticks));
+		input_event._time = std::max(now - age, _last_event_time);
+		input_event._x = _mouse_x;
+		input_event._y = _mouse_y;
+		_last_event_time = input_event._time;
+
+		_events.push(input_event);
+	}
+}
+
+bool ga_input::update(ga_frame_params* params)
+{
+	GA_PROFILE_SCOPE("input");
+
+	poll();
+
+	if (_player)
+	{
+		return play(params);
 	}
 
-	_pressed_mask = _button_mask & ~previous_button_mask;
-	_released_mask = previous_button_mask & ~_button_mask;
+	params->_mouse_click_mask = _mouse_click_mask;
+	_mouse_click_mask = 0;
 
 	params->_button_mask = _button_mask;
 	params->_mouse_press_mask = _mouse_button_mask;
 	params->_mouse_x = _mouse_x;
 	params->_mouse_y = _mouse_y;
 
+	// Everything polled since the last frame.
+	params->_input_events = &_events;
+	params->_input_event_begin = _frame_event;
+	params->_input_event_end = _events.get_head();
+	params->_input_begin_time = _last_time;
+	_frame_event = params->_input_event_end;
+
 	// Toggle pause if the p key is pressed.
 	if (_pressed_mask & k_button_p)
 	{
 		_paused = !_paused;
 	}
 
-	// Update time. Cap frame rate at ~60 fps.
+	// Update time. The frame rate is up to the caller; see ga_frame_pacer.
 	auto t0 = _last_time;
 	auto t1 = std::chrono::high_resolution_clock::now();
 
-	auto delta_time = t1 - t0;
 	auto min_delta_time = std::chrono::milliseconds(16);
 	auto max_delta_time = std::chrono::milliseconds(32);
-	if (delta_time < min_delta_time)
-	{
-#if defined(GA_MINGW)
-		uint32_t ms = std::chrono::duration_cast<std::chrono::duration<float>>(min_delta_time - delta_time).count();
-		usleep(ms * 1000);
-#else
-		std::this_thread::sleep_for(min_delta_time - delta_time);
-#endif
-	}
 
-	t1 = std::chrono::high_resolution_clock::now();
 	_last_time = t1;
 
 	params->_current_time = t1;
@@ -238,5 +252,33 @@ bool ga_input::update(ga_frame_params* params)
 		params->_single_step = true;
 	}
 
-	return result;
+	// Polls gather presses and releases for the next frame, including ones
+	// too quick to show up in the button mask.
+	_pressed_mask = 0;
+	_released_mask = 0;
+
+	if (_recorder)
+	{
+		_recorder->record(params);
+	}
+
+	return !_quit;
+}
+
+bool ga_input::play(ga_frame_params* params)
+{
+	// Device input is dropped, but was still polled so the window can close.
+	_mouse_click_mask = 0;
+	_pressed_mask = 0;
+	_released_mask = 0;
+	_frame_event = _events.get_head();
+
+	// The sim runs on recorded time. Current time stays real so latency can
+	// still be measured.
+	auto t1 = std::chrono::high_resolution_clock::now();
+	params->_input_begin_time = _last_time;
+	params->_current_time = t1;
+	_last_time = t1;
+
+	return _player->play(params) && !_quit;
 }
@@ -9,12 +9,19 @@
 ** This file is distributed under the MIT License. See LICENSE.txt.
 */
 
+#include "ga_input_ring.h"
+
 #include <chrono>
 #include <cstdint>
 
 /*
 ** Represents the input stage of the frame.
 ** Owns the window, user input devices and clock.
+**
+** Devices are read by poll(), which can run many times a frame; see
+** ga_frame_pacer::set_poll. Each change goes into an event ring with the
+** time it happened. update() runs once a frame and hands the frame its
+** events along with the usual masks.
 */
 class ga_input
 {
@@ -24,21 +31,44 @@ public:
 
 	bool update(struct ga_frame_params* params);
 
+	/* Reads pending device events into the ring. Main thread only. */
+	void poll();
+
+	/* Logs each frame's input. Null to stop. */
+	void set_recorder(class ga_input_recorder* recorder) { _recorder = recorder; }
+
+	/*
+	** Takes each frame's input and delta time from a log instead of the
+	** devices. update() returns false when the log runs out. Null to stop.
+	*/
+	void set_player(class ga_input_player* player) { _player = player; }
+
 	void* get_window() const { return _window; }
 
 private:
+	bool play(struct ga_frame_params* params);
+
 	uint64_t _button_mask;
 	uint64_t _pressed_mask;
 	uint64_t _released_mask;
 
 	uint64_t _mouse_button_mask;
+	uint64_t _mouse_click_mask;
 
 	float _mouse_x;
 	float _mouse_y;
 
 	std::chrono::high_resolution_clock::time_point _last_time;
 
+	ga_input_ring _events;
+	uint64_t _frame_event;
+	std::chrono::high_resolution_clock::time_point _last_event_time;
+
 	void* _window;
 
+	class ga_input_recorder* _recorder;
+	class ga_input_player* _player;
+
 	bool _paused;
+	bool _quit;
 };
@@ -0,0 +1,245 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_input_log.h"
+#include "ga_frame_params.h"
+
+#include <cstring>
+
+// File starts with the magic and a version byte. Each frame follows as a
+// flags byte, the delta time in nanoseconds, then the fields its flags name.
+// Integers are unsigned LEB128, floats are 4 bytes little-endian.
+static const char k_log_magic[4] = { 'G', 'A', 'I', 'L' };
+static const uint8_t k_log_version = 1;
+
+enum ga_input_log_flags_t
+{
+	k_log_button_mask = 1 << 0,
+	k_log_mouse_click_mask = 1 << 1,
+	k_log_mouse_press_mask = 1 << 2,
+	k_log_mouse_position = 1 << 3,
+	k_log_single_step = 1 << 4,
+};
+
+static void write_varint(FILE* file, uint64_t value)
+{
+	do
+	{
+		uint8_t byte = value & 0x7f;
+		value >>= 7;
+		fputc(byte | (value ? 0x80 : 0), file);
+	} while (value);
+}
+
+static bool read_varint(FILE* file, uint64_t* value)
+{
+	*value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		int byte = fgetc(file);
+		if (byte == EOF)
+		{
+			return false;
+		}
+		*value |= uint64_t(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void write_float(FILE* file, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	for (int i = 0; i < 4; ++i)
+	{
+		fputc((bits >> (i * 8)) & 0xff, file);
+	}
+}
+
+static bool read_float(FILE* file, float* value)
+{
+	uint32_t bits = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		int byte = fgetc(file);
+		if (byte == EOF)
+		{
+			return false;
+		}
+		bits |= uint32_t(byte) << (i * 8);
+	}
+	memcpy(value, &bits, sizeof(bits));
+	return true;
+}
+
+ga_input_recorder::ga_input_recorder() : _file(nullptr), _frames(0)
+{
+}
+
+ga_input_recorder::~ga_input_recorder()
+{
+	close();
+}
+
+bool ga_input_recorder::open(const char* path)
+{
+	close();
+
+	_file = fopen(path, "wb");
+	if (!_file)
+	{
+		return false;
+	}
+
+	fwrite(k_log_magic, 1, sizeof(k_log_magic), _file);
+	fputc(k_log_version, _file);
+
+	_frames = 0;
+	_button_mask = 0;
+	_mouse_press_mask = 0;
+	_mouse_x = 0.0f;
+	_mouse_y = 0.0f;
+	return true;
+}
+
+void ga_input_recorder::close()
+{
+	if (_file)
+	{
+		fclose(_file);
+		_file = nullptr;
+	}
+}
+
+void ga_input_recorder::record(const ga_frame_params* params)
+{
+	if (!_file)
+	{
+		return;
+	}
+
+	uint8_t flags = 0;
+	flags |= params->_button_mask != _button_mask ? k_log_button_mask : 0;
+	flags |= params->_mouse_click_mask != 0 ? k_log_mouse_click_mask : 0;
+	flags |= params->_mouse_press_mask != _mouse_press_mask ? k_log_mouse_press_mask : 0;
+	flags |= params->_mouse_x != _mouse_x || params->_mouse_y != _mouse_y ? k_log_mouse_position : 0;
+	flags |= params->_single_step ? k_log_single_step : 0;
+
+	fputc(flags, _file);
+	write_varint(_file, uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(params->_delta_time).count()));
+
+	if (flags & k_log_button_mask)
+	{
+		write_varint(_file, params->_button_mask);
+	}
+	if (flags & k_log_mouse_click_mask)
+	{
+		write_varint(_file, params->_mouse_click_mask);
+	}
+	if (flags & k_log_mouse_press_mask)
+	{
+		write_varint(_file, params->_mouse_press_mask);
+	}
+	if (flags & k_log_mouse_position)
+	{
+		write_float(_file, params->_mouse_x);
+		write_float(_file, params->_mouse_y);
+	}
+
+	_button_mask = params->_button_mask;
+	_mouse_press_mask = params->_mouse_press_mask;
+	_mouse_x = params->_mouse_x;
+	_mouse_y = params->_mouse_y;
+	_frames++;
+}
+
+ga_input_player::ga_input_player() : _file(nullptr), _frames(0)
+{
+}
+
+ga_input_player::~ga_input_player()
+{
+	close();
+}
+
+bool ga_input_player::open(const char* path)
+{
+	close();
+
+	_file = fopen(path, "rb");
+	if (!_file)
+	{
+		return false;
+	}
+
+	char magic[sizeof(k_log_magic)];
+	if (fread(magic, 1, sizeof(magic), _file) != sizeof(magic) ||
+		memcmp(magic, k_log_magic, sizeof(magic)) != 0 ||
+		fgetc(_file) != k_log_version)
+	{
+		close();
+		return false;
+	}
+
+	_frames = 0;
+	_button_mask = 0;
+	_mouse_press_mask = 0;
+	_mouse_x = 0.0f;
+	_mouse_y = 0.0f;
+	return true;
+}
+
+void ga_input_player::close()
+{
+	if (_file)
+	{
+		fclose(_file);
+		_file = nullptr;
+	}
+}
+
+bool ga_input_player::play(ga_frame_params* params)
+{
+	if (!_file)
+	{
+		return false;
+	}
+
+	int flags = fgetc(_file);
+	uint64_t delta_time;
+	if (flags == EOF || !read_varint(_file, &delta_time))
+	{
+		return false;
+	}
+
+	uint64_t mouse_click_mask = 0;
+	if ((flags & k_log_button_mask && !read_varint(_file, &_button_mask)) ||
+		(flags & k_log_mouse_click_mask && !read_varint(_file, &mouse_click_mask)) ||
+		(flags & k_log_mouse_press_mask && !read_varint(_file, &_mouse_press_mask)) ||
+		(flags & k_log_mouse_position && !(read_float(_file, &_mouse_x) && read_float(_file, &_mouse_y))))
+	{
+		return false;
+	}
+
+	params->_delta_time = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+		std::chrono::nanoseconds(delta_time));
+	params->_button_mask = _button_mask;
+	params->_mouse_click_mask = mouse_click_mask;
+	params->_mouse_press_mask = _mouse_press_mask;
+	params->_mouse_x = _mouse_x;
+	params->_mouse_y = _mouse_y;
+	params->_single_step = (flags & k_log_single_step) != 0;
+
+	_frames++;
+	return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+/*
+** Writes the input fields of each frame's params to a binary log.
+**
+** Covers what the sim reads: button and mouse masks, mouse position, delta
+** time and single step. Each frame stores its delta time and only the
+** fields that changed, so a typical frame takes a few bytes.
+*/
+class ga_input_recorder
+{
+public:
+	ga_input_recorder();
+	~ga_input_recorder();
+
+	bool open(const char* path);
+	void close();
+
+	void record(const struct ga_frame_params* params);
+
+	int get_frame_count() const { return _frames; }
+
+private:
+	FILE* _file;
+	int _frames;
+
+	uint64_t _button_mask;
+	uint64_t _mouse_press_mask;
+	float _mouse_x;
+	float _mouse_y;
+};
+
+/*
+** Reads a log written by ga_input_recorder back into frame params, one
+** frame per call, with the recorded delta times.
+*/
+class ga_input_player
+{
+public:
+	ga_input_player();
+	~ga_input_player();
+
+	bool open(const char* path);
+	void close();
+
+	/* Fills the input fields of params. Returns false at the end of the log. */
+	bool play(struct ga_frame_params* params);
+
+	int get_frame_count() const { return _frames; }
+
+private:
+	FILE* _file;
+	int _frames;
+
+	uint64_t _button_mask;
+	uint64_t _mouse_press_mask;
+	float _mouse_x;
+	float _mouse_y;
+};
@@ -0,0 +1,129 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_input_ring.h"
+
+#include <algorithm>
+
+static const uint64_t k_slot_writing = ~uint64_t(0);
+
+ga_input_ring::ga_input_ring(int capacity)
+{
+	uint64_t size = 1;
+	while (size < uint64_t(capacity))
+	{
+		size <<= 1;
+	}
+
+	_slots = new slot_t[size];
+	for (uint64_t i = 0; i < size; ++i)
+	{
+		_slots[i]._index.store(k_slot_writing, std::memory_order_relaxed);
+	}
+	_mask = size - 1;
+	_head.store(0, std::memory_order_relaxed);
+}
+
+ga_input_ring::~ga_input_ring()
+{
+	delete[] _slots;
+}
+
+void ga_input_ring::push(const ga_input_event& event)
+{
+	uint64_t index = _head.load(std::memory_order_relaxed);
+	slot_t& slot = _slots[index & _mask];
+
+	// Mark the slot torn first, so a reader still copying the event it held
+	// can tell.
+	slot._index.store(k_slot_writing, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot._event = event;
+	slot._index.store(index, std::memory_order_release);
+
+	_head.store(index + 1, std::memory_order_release);
+}
+
+uint64_t ga_input_ring::get_head() const
+{
+	return _head.load(std::memory_order_acquire);
+}
+
+bool ga_input_ring::get(uint64_t index, ga_input_event* event) const
+{
+	const slot_t& slot = _slots[index & _mask];
+	if (slot._index.load(std::memory_order_acquire) != index)
+	{
+		return false;
+	}
+
+	*event = slot._event;
+
+	// If the writer got to the slot while we copied, the copy is no good.
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return slot._index.load(std::memory_order_relaxed) == index;
+}
+
+std::chrono::high_resolution_clock::duration ga_input_ring::get_held_time(
+	uint64_t begin,
+	uint64_t end,
+	uint64_t button,
+	uint64_t end_mask,
+	std::chrono::high_resolution_clock::time_point from,
+	std::chrono::high_resolution_clock::time_point to) const
+{
+	typedef std::chrono::high_resolution_clock::duration duration_t;
+	typedef std::chrono::high_resolution_clock::time_point time_point_t;
+
+	// Held or not for the whole window unless an event says otherwise.
+	duration_t whole = to > from ? to - from : duration_t::zero();
+	duration_t end_state = (end_mask & button) ? whole : duration_t::zero();
+
+	// The state going in is the state before the first change to button.
+	bool started = false;
+	bool held = false;
+	time_point_t since = from;
+	duration_t total = duration_t::zero();
+
+	for (uint64_t i = begin; i < end; ++i)
+	{
+		ga_input_event event;
+		if (!get(i, &event))
+		{
+			return end_state;
+		}
+		if (!(event._button & button) || (event._type != k_input_key_down && event._type != k_input_key_up))
+		{
+			continue;
+		}
+
+		time_point_t t = std::min(std::max(event._time, from), to);
+		if (!started)
+		{
+			held = event._type == k_input_key_up;
+			started = true;
+		}
+		if (held)
+		{
+			total += t - since;
+		}
+		held = event._type == k_input_key_down;
+		since = t;
+	}
+
+	if (!started)
+	{
+		return end_state;
+	}
+	if (held)
+	{
+		total += to - since;
+	}
+	return total;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+enum ga_input_event_type_t
+{
+	k_input_key_down,
+	k_input_key_up,
+	k_input_mouse_move,
+	k_input_mouse_down,
+	k_input_mouse_up,
+};
+
+/*
+** One input change, stamped with when it happened.
+*/
+struct ga_input_event
+{
+	std::chrono::high_resolution_clock::time_point _time;
+	ga_input_event_type_t _type;
+
+	// The bit that changed and the whole mask after the change: ga_button_t
+	// bits for keys, 1 << SDL button index for the mouse.
+	uint64_t _button;
+	uint64_t _mask;
+
+	// Mouse position at the time of the event.
+	float _x;
+	float _y;
+};
+
+/*
+** Ring of input events with one writer and any number of readers.
+**
+** Events are numbered in order. Readers keep their own position and read
+** up to get_head(), so each stage can take events up to its own sample
+** time. Nothing waits on a reader. Once the writer laps one, its oldest
+** events are gone and get() says so.
+*/
+class ga_input_ring
+{
+public:
+	/* Capacity is rounded up to a power of two. */
+	ga_input_ring(int capacity = 1024);
+	~ga_input_ring();
+
+	/* Writer only. */
+	void push(const ga_input_event& event);
+
+	/* Number of the next event to be written. */
+	uint64_t get_head() const;
+
+	/* Copies out event number index. Returns false if it's been overwritten. */
+	bool get(uint64_t index, ga_input_event* event) const;
+
+	/*
+	** How long button was held between from and to, going by key events
+	** [begin, end). end_mask is the button mask as of event end.
+	*/
+	std::chrono::high_resolution_clock::duration get_held_time(
+		uint64_t begin,
+		uint64_t end,
+		uint64_t button,
+		uint64_t end_mask,
+		std::chrono::high_resolution_clock::time_point from,
+		std::chrono::high_resolution_clock::time_point to) const;
+
+private:
+	struct slot_t
+	{
+		// Index of the event in the slot, or ~0 while it's being written.
+		std::atomic<uint64_t> _index;
+		ga_input_event _event;
+	};
+
+	slot_t* _slots;
+	uint64_t _mask;
+	std::atomic<uint64_t> _head;
+};
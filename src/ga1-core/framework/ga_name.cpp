@@ -0,0 +1,60 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_name.h"
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct ga_name_table_t
+{
+	std::mutex _mutex;
+
+	// A deque so strings don't move as the table grows.
+	std::deque<std::string> _strings;
+	std::unordered_map<std::string, ga_name_t> _ids;
+
+	ga_name_table_t()
+	{
+		_strings.push_back("");
+		_ids[""] = 0;
+	}
+};
+
+static ga_name_table_t& get_name_table()
+{
+	static ga_name_table_t table;
+	return table;
+}
+
+ga_name_t ga_intern_name(const char* name)
+{
+	ga_name_table_t& table = get_name_table();
+	std::lock_guard<std::mutex> lock(table._mutex);
+
+	auto it = table._ids.find(name);
+	if (it != table._ids.end())
+	{
+		return it->second;
+	}
+
+	ga_name_t id = ga_name_t(table._strings.size());
+	table._strings.push_back(name);
+	table._ids[table._strings.back()] = id;
+	return id;
+}
+
+const char* ga_get_name_string(ga_name_t name)
+{
+	ga_name_table_t& table = get_name_table();
+	std::lock_guard<std::mutex> lock(table._mutex);
+	return name < table._strings.size() ? table._strings[name].c_str() : "";
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include <cstdint>
+
+/*
+** Interned string id. Equal strings get equal ids, and the string lives
+** until exit. 0 is the empty name.
+*/
+typedef uint32_t ga_name_t;
+
+// Takes a lock and may allocate, so intern once and keep the id, rather
+// than interning every frame.
+ga_name_t ga_intern_name(const char* name);
+
+const char* ga_get_name_string(ga_name_t name);
@@ -10,6 +10,7 @@
 #include "ga_output.h"
 
 #include "ga_frame_params.h"
+#include "ga_profiler.h"
 
 #include "graphics/ga_material.h"
 #include "graphics/ga_program.h"
@@ -43,8 +44,15 @@ ga_output::~ga_output()
 	delete _default_material;
 }
 
+void ga_output::set_vsync(bool vsync)
+{
+	SDL_GL_SetSwapInterval(vsync ? 1 : 0);
+}
+
 void ga_output::update(ga_frame_params* params)
 {
+	GA_PROFILE_SCOPE("output");
+
 	// Update viewport in case window was resized:
 	int width, height;
 	SDL_GetWindowSize(static_cast<SDL_Window* >(_window), &width, &height);
@@ -67,11 +75,15 @@ void ga_output::update(ga_frame_params* params)
 	ga_mat4f view_ortho = view * ortho;
 
 	// Draw all static geometry:
-	for (auto& d : params->_static_drawcalls)
+	for (int b = 0; b < params->_static_drawcalls.get_bucket_count(); ++b)
 	{
-		d._material->bind(view_perspective, d._transform);
-		glBindVertexArray(d._vao);
-		glDrawElements(d._draw_mode, d._index_count, GL_UNSIGNED_SHORT, 0);
+		for (auto& d : params->_static_drawcalls.get_bucket(b))
+		{
+			d._material->set_skin(d._skin, d._skin_count);
+			d._material->bind(view_perspective, d._transform);
+			glBindVertexArray(d._vao);
+			glDrawElements(d._draw_mode, d._index_count, GL_UNSIGNED_SHORT, 0);
+		}
 	}
 
 	// Draw all dynamic geometry:
@@ -82,10 +94,21 @@ void ga_output::update(ga_frame_params* params)
 	assert(error == GL_NONE);
 
 	// Swap frame buffers:
-	SDL_GL_SwapWindow(static_cast<SDL_Window* >(_window));
+	{
+		GA_PROFILE_SCOPE("output/swap");
+		SDL_GL_SwapWindow(static_cast<SDL_Window* >(_window));
+	}
+}
+
+void ga_output::draw_dynamic(const ga_drawcall_list<ga_dynamic_drawcall>& drawcalls, const ga_mat4f& view_proj)
+{
+	for (int b = 0; b < drawcalls.get_bucket_count(); ++b)
+	{
+		draw_dynamic(drawcalls.get_bucket(b), view_proj);
+	}
 }
 
-void ga_output::draw_dynamic(const std::vector<ga_dynamic_drawcall>& drawcalls, const ga_mat4f& view_proj)
+void ga_output::draw_dynamic(const ga_frame_vector<ga_dynamic_drawcall>& drawcalls, const ga_mat4f& view_proj)
 {
 	for (auto& d : drawcalls)
 	{
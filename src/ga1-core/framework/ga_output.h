@@ -10,10 +10,10 @@
 */
 
 #include "ga_drawcall.h"
+#include "ga_drawcall_list.h"
+#include "jobs/ga_frame_arena.h"
 #include "math/ga_mat4f.h"
 
-#include <vector>
-
 /*
 ** Represents the output stage of the frame.
 ** Owns whatever is drawn on the screen.
@@ -26,8 +26,12 @@ public:
 
 	void update(struct ga_frame_params* params);
 
+	// Whether swaps wait for vertical blank. Off by default.
+	void set_vsync(bool vsync);
+
 private:
-	void draw_dynamic(const std::vector<ga_dynamic_drawcall>& drawcalls, const ga_mat4f& view_proj);
+	void draw_dynamic(const ga_drawcall_list<ga_dynamic_drawcall>& drawcalls, const ga_mat4f& view_proj);
+	void draw_dynamic(const ga_frame_vector<ga_dynamic_drawcall>& drawcalls, const ga_mat4f& view_proj);
 
 	void* _window;
 
@@ -0,0 +1,82 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+/*
+** Cost of a profile marker, disabled and enabled, against an empty loop.
+*/
+
+#include "ga_profiler.h"
+
+#include "jobs/ga_job.h"
+
+#include <chrono>
+#include <cstdio>
+
+typedef std::chrono::high_resolution_clock ga_bench_clock_t;
+
+static const int k_iterations = 10000000;
+
+// Kept out of line, and with a side effect, so the loop can't be folded away.
+static volatile int g_sink = 0;
+
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+static void marked(int i)
+{
+	GA_PROFILE_SCOPE("bench/marked");
+	g_sink = i;
+}
+
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+static void unmarked(int i)
+{
+	g_sink = i;
+}
+
+template<class T>
+static double ns_per_call(T func)
+{
+	auto t0 = ga_bench_clock_t::now();
+	for (int i = 0; i < k_iterations; ++i)
+	{
+		func(i);
+	}
+	auto t1 = ga_bench_clock_t::now();
+	return std::chrono::duration<double, std::nano>(t1 - t0).count() / k_iterations;
+}
+
+int main(int argc, const char** argv)
+{
+	ga_job::startup(ga_job_config());
+	ga_profiler::startup();
+
+	double base = ns_per_call(unmarked);
+
+	ga_profiler::set_enabled(false);
+	double disabled = ns_per_call(marked);
+
+	ga_profiler::set_enabled(true);
+	double enabled = ns_per_call(marked);
+
+	printf("%16s %8.2f ns per call\n", "no marker", base);
+	printf("%16s %8.2f ns per call (+%.2f)\n", "disabled", disabled, disabled - base);
+	printf("%16s %8.2f ns per call (+%.2f)\n", "enabled", enabled, enabled - base);
+
+	ga_profiler::shutdown();
+	ga_job::shutdown();
+
+	return 0;
+}
@@ -0,0 +1,238 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_profiler.h"
+
+#include "jobs/ga_job.h"
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+static const int k_ga_profiler_max_markers = 128;
+
+typedef std::chrono::steady_clock::duration ga_profiler_duration_t;
+typedef ga_profiler_duration_t::rep ga_profiler_rep_t;
+
+// Running totals for one thread. Only that thread writes them, so they
+// never reset; begin_frame diffs them against the last frame's sums.
+struct ga_profiler_thread_t
+{
+	std::atomic<ga_profiler_rep_t> _totals[k_ga_profiler_max_markers];
+};
+
+struct ga_profiler_impl_t
+{
+	std::vector<ga_profiler_thread_t*> _threads;
+
+	int _history_size;
+	uint64_t _frame_count;
+
+	// Per frame slot: the frame's length, then each marker's time.
+	std::vector<ga_profiler_rep_t> _frame_times;
+	std::vector<ga_profiler_rep_t> _marker_times;
+
+	ga_profiler_rep_t _last_totals[k_ga_profiler_max_markers];
+	std::chrono::steady_clock::time_point _last_begin;
+	bool _begun;
+};
+
+// Markers register on first use, which may be before startup.
+static std::mutex _ga_profiler_marker_mutex;
+static const char* _ga_profiler_marker_names[k_ga_profiler_max_markers];
+static std::atomic<int> _ga_profiler_marker_count(0);
+
+std::atomic<bool> ga_profiler::_enabled(false);
+void* ga_profiler::_impl = 0;
+
+void ga_profiler::startup(int history_size)
+{
+	auto impl = new ga_profiler_impl_t;
+
+	for (int i = 0; i < ga_job::get_thread_count(); ++i)
+	{
+		ga_profiler_thread_t* thread = new ga_profiler_thread_t;
+		for (int m = 0; m < k_ga_profiler_max_markers; ++m)
+		{
+			thread->_totals[m].store(0, std::memory_order_relaxed);
+		}
+		impl->_threads.push_back(thread);
+	}
+
+	impl->_history_size = history_size;
+	impl->_frame_count = 0;
+	impl->_frame_times.resize(history_size, 0);
+	impl->_marker_times.resize(size_t(history_size) * k_ga_profiler_max_markers, 0);
+	memset(impl->_last_totals, 0, sizeof(impl->_last_totals));
+	impl->_begun = false;
+
+	_impl = impl;
+}
+
+void ga_profiler::shutdown()
+{
+	ga_profiler_impl_t* impl = static_cast<ga_profiler_impl_t*>(_impl);
+
+	_enabled.store(false, std::memory_order_relaxed);
+	_impl = 0;
+
+	for (auto thread : impl->_threads)
+	{
+		delete thread;
+	}
+	delete impl;
+}
+
+void ga_profiler::set_enabled(bool enabled)
+{
+	_enabled.store(enabled && _impl, std::memory_order_relaxed);
+}
+
+void ga_profiler::begin_frame()
+{
+	ga_profiler_impl_t* impl = static_cast<ga_profiler_impl_t*>(_impl);
+	if (!impl)
+	{
+		return;
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	if (impl->_begun)
+	{
+		int slot = int(impl->_frame_count % impl->_history_size);
+		impl->_frame_times[slot] = (now - impl->_last_begin).count();
+
+		ga_profiler_rep_t* times = &impl->_marker_times[size_t(slot) * k_ga_profiler_max_markers];
+		int marker_count = _ga_profiler_marker_count.load(std::memory_order_acquire);
+		for (int m = 0; m < marker_count; ++m)
+		{
+			ga_profiler_rep_t total = 0;
+			for (auto thread : impl->_threads)
+			{
+				total += thread->_totals[m].load(std::memory_order_relaxed);
+			}
+			times[m] = total - impl->_last_totals[m];
+			impl->_last_totals[m] = total;
+		}
+
+		impl->_frame_count++;
+	}
+
+	impl->_last_begin = now;
+	impl->_begun = true;
+}
+
+int ga_profiler::register_marker(const char* name)
+{
+	std::lock_guard<std::mutex> lock(_ga_profiler_marker_mutex);
+
+	int count = _ga_profiler_marker_count.load(std::memory_order_relaxed);
+	for (int m = 0; m < count; ++m)
+	{
+		if (strcmp(_ga_profiler_marker_names[m], name) == 0)
+		{
+			return m;
+		}
+	}
+
+	if (count == k_ga_profiler_max_markers)
+	{
+		return -1;
+	}
+
+	_ga_profiler_marker_names[count] = name;
+	_ga_profiler_marker_count.store(count + 1, std::memory_order_release);
+	return count;
+}
+
+void ga_profiler::record(int marker, std::chrono::steady_clock::duration time)
+{
+	ga_profiler_impl_t* impl = static_cast<ga_profiler_impl_t*>(_impl);
+	if (!impl)
+	{
+		return;
+	}
+
+	// Each thread has its own totals, so no read-modify-write is needed.
+	std::atomic<ga_profiler_rep_t>& total = impl->_threads[ga_job::get_thread_index()]->_totals[marker];
+	total.store(total.load(std::memory_order_relaxed) + time.count(), std::memory_order_relaxed);
+}
+
+int ga_profiler::get_marker_count()
+{
+	return _ga_profiler_marker_count.load(std::memory_order_acquire);
+}
+
+const char* ga_profiler::get_marker_name(int marker)
+{
+	return _ga_profiler_marker_names[marker];
+}
+
+int ga_profiler::get_history_count()
+{
+	ga_profiler_impl_t* impl = static_cast<ga_profiler_impl_t*>(_impl);
+	if (!impl)
+	{
+		return 0;
+	}
+	return impl->_frame_count < uint64_t(impl->_history_size) ? int(impl->_frame_count) : impl->_history_size;
+}
+
+std::chrono::steady_clock::duration ga_profiler::get_frame_time(int age)
+{
+	ga_profiler_impl_t* impl = static_cast<ga_profiler_impl_t*>(_impl);
+	int slot = int((impl->_frame_count - 1 - age) % impl->_history_size);
+	return ga_profiler_duration_t(impl->_frame_times[slot]);
+}
+
+std::chrono::steady_clock::duration ga_profiler::get_marker_time(int marker, int age)
+{
+	ga_profiler_impl_t* impl = static_cast<ga_profiler_impl_t*>(_impl);
+	int slot = int((impl->_frame_count - 1 - age) % impl->_history_size);
+	return ga_profiler_duration_t(impl->_marker_times[size_t(slot) * k_ga_profiler_max_markers + marker]);
+}
+
+bool ga_profiler::write_csv(const char* path)
+{
+	ga_profiler_impl_t* impl = static_cast<ga_profiler_impl_t*>(_impl);
+	if (!impl)
+	{
+		return false;
+	}
+
+	FILE* file = fopen(path, "w");
+	if (!file)
+	{
+		return false;
+	}
+
+	int marker_count = get_marker_count();
+
+	fprintf(file, "frame,frame_ms");
+	for (int m = 0; m < marker_count; ++m)
+	{
+		fprintf(file, ",\"%s\"", _ga_profiler_marker_names[m]);
+	}
+	fprintf(file, "\n");
+
+	int history_count = get_history_count();
+	for (int age = history_count - 1; age >= 0; --age)
+	{
+		fprintf(file, "%llu,%.4f", (unsigned long long)(impl->_frame_count - 1 - age),
+			std::chrono::duration<double, std::milli>(get_frame_time(age)).count());
+		for (int m = 0; m < marker_count; ++m)
+		{
+			fprintf(file, ",%.4f", std::chrono::duration<double, std::milli>(get_marker_time(m, age)).count());
+		}
+		fprintf(file, "\n");
+	}
+
+	return fclose(file) == 0;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/*
+** Set to 0 to compile profile markers out entirely. When 1 they can still
+** be switched off at runtime, leaving a load and a branch each.
+*/
+#if !defined(GA_PROFILE)
+#define GA_PROFILE 1
+#endif
+
+/*
+** CPU time per frame stage, kept for the last few hundred frames.
+**
+** Code marks a scope with GA_PROFILE_SCOPE("name"). Each marker's time is
+** summed over every thread and every time it ran in the frame, so a marker
+** inside a parallel_for can add up to more than the frame.
+**
+** Nesting comes from the name rather than the call stack, since a job can
+** finish on a different thread than it started: "sim/update" is drawn under
+** "sim".
+*/
+class ga_profiler
+{
+public:
+	/* Call after ga_job::startup. Starts disabled. */
+	static void startup(int history_size = 240);
+	static void shutdown();
+
+	static void set_enabled(bool enabled);
+	static bool is_enabled() { return _enabled.load(std::memory_order_relaxed); }
+
+	/*
+	** Closes out the last frame into the history. Call from the main thread
+	** at the top of the frame, while no marked code is running.
+	*/
+	static void begin_frame();
+
+	/* Returns the same id for the same name. -1 once the table is full. */
+	static int register_marker(const char* name);
+	static void record(int marker, std::chrono::steady_clock::duration time);
+
+	static int get_marker_count();
+	static const char* get_marker_name(int marker);
+
+	/*
+	** History of complete frames, age 0 being the latest. Not to be read
+	** while begin_frame runs.
+	*/
+	static int get_history_count();
+	static std::chrono::steady_clock::duration get_frame_time(int age);
+	static std::chrono::steady_clock::duration get_marker_time(int marker, int age);
+
+	/* One row per frame in the history, oldest first. Returns false on failure. */
+	static bool write_csv(const char* path);
+
+private:
+	static std::atomic<bool> _enabled;
+	static void* _impl;
+};
+
+/* A named profile marker. Construct once per call site. */
+struct ga_profile_marker
+{
+	ga_profile_marker(const char* name) : _index(ga_profiler::register_marker(name)) {}
+	int _index;
+};
+
+/* Times its lifetime against a marker, if the profiler is enabled. */
+class ga_profile_scope
+{
+public:
+	ga_profile_scope(const ga_profile_marker& marker) : _marker(-1)
+	{
+		if (ga_profiler::is_enabled())
+		{
+			_marker = marker._index;
+			_start = std::chrono::steady_clock::now();
+		}
+	}
+
+	~ga_profile_scope()
+	{
+		if (_marker >= 0)
+		{
+			ga_profiler::record(_marker, std::chrono::steady_clock::now() - _start);
+		}
+	}
+
+private:
+	int _marker;
+	std::chrono::steady_clock::time_point _start;
+};
+
+#define GA_PROFILE_JOIN_INNER(a, b) a##b
+#define GA_PROFILE_JOIN(a, b) GA_PROFILE_JOIN_INNER(a, b)
+
+#if GA_PROFILE
+#define GA_PROFILE_SCOPE(name) \
+	static ga_profile_marker GA_PROFILE_JOIN(_ga_profile_marker_, __LINE__)(name); \
+	ga_profile_scope GA_PROFILE_JOIN(_ga_profile_scope_, __LINE__)(GA_PROFILE_JOIN(_ga_profile_marker_, __LINE__))
+#else
+#define GA_PROFILE_SCOPE(name) ((void)0)
+#endif
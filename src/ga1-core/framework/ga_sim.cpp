@@ -10,15 +10,19 @@
 #include "ga_sim.h"
 
 #include "ga_compiler_defines.h"
+#include "ga_profiler.h"
 
+#include "entity/ga_component.h"
 #include "entity/ga_entity.h"
 #include "jobs/ga_job.h"
 
-#if defined(GA_MINGW)
-#include <malloc.h>
-#endif
+#include <algorithm>
+#include <typeinfo>
 
-ga_sim::ga_sim()
+// Components updated per chunk by one job.
+static const int k_component_grain = 8;
+
+ga_sim::ga_sim() : _batches_dirty(false)
 {
 }
 
@@ -26,71 +30,193 @@ ga_sim::~ga_sim()
 {
 }
 
-void ga_sim::add_entity(ga_entity* ent)
+ga_entity_id ga_sim::add_entity(ga_entity* ent)
 {
-	_entities.push_back(ent);
+	ga_entity_id id = _world.create();
+	_world.add(id, ga_legacy_entity{ ent });
+
+	ent->_sim = this;
+	for (ga_component* comp : ent->get_components())
+	{
+		add_component(comp);
+	}
+	return id;
 }
 
-void ga_sim::update(ga_frame_params* params)
+void ga_sim::add_component(ga_component* comp)
 {
-	// Create jobs that update all entities in parallel (one job per entity).
-	// There are 2 components:
-	// 1. The job declarations; a function and a pointer to data for that function.
-	// 2. The data for each job; an entity and the frame_params.
+	_pending_components.push_back(comp);
+	_batches_dirty = true;
+}
 
-	auto decls = static_cast<ga_job_decl_t*>(alloca(sizeof(ga_job_decl_t) * _entities.size()));
+void ga_sim::add_system(const ga_system& system)
+{
+	system_t entry;
+	entry._system = system;
+	_systems.push_back(entry);
+	_batches_dirty = true;
+}
+
+void ga_sim::update(ga_frame_params* params)
+{
+	GA_PROFILE_SCOPE("sim/update");
 
-	struct update_data_t
+	if (_batches_dirty)
 	{
-		ga_entity* _entity;
-		ga_frame_params* _params;
-	};
-	auto update_data = static_cast<update_data_t*>(alloca(sizeof(update_data_t) * _entities.size()));
+		add_pending_components();
+		build_batches();
+	}
+
+	run_batches(params, false);
+}
+
+void ga_sim::late_update(ga_frame_params* params)
+{
+	GA_PROFILE_SCOPE("sim/late_update");
 
-	for (int i = 0; i < _entities.size(); ++i)
+	if (_batches_dirty)
 	{
-		update_data[i]._entity = _entities[i];
-		update_data[i]._params = params;
+		add_pending_components();
+		build_batches();
+	}
+
+	run_batches(params, true);
+}
 
-		decls[i]._data = update_data + i;
-		decls[i]._entry = [](void* data)
+void ga_sim::add_pending_components()
+{
+	for (ga_component* comp : _pending_components)
+	{
+		std::type_index type(typeid(*comp));
+		auto it = _component_systems.find(type);
+		if (it == _component_systems.end())
 		{
-			auto update_data = static_cast<update_data_t*>(data);
-			update_data->_entity->update(update_data->_params);
-		};
+			system_t entry;
+			entry._system._name = type.name();
+			comp->get_access(&entry._system._reads, &entry._system._writes);
+			entry._system._update = nullptr;
+			entry._system._late_update = nullptr;
+			entry._system._data = nullptr;
+			_systems.push_back(entry);
+
+			it = _component_systems.insert(std::make_pair(type, int(_systems.size()) - 1)).first;
+		}
+		_systems[it->second]._components.push_back(comp);
 	}
+	_pending_components.clear();
 
-	// Dispatch the jobs:
-	int32_t update_counter;
-	ga_job::run(decls, int(_entities.size()), &update_counter);
-	ga_job::wait(&update_counter);
+	// Keep an entity's components of one class next to each other, in the
+	// order they were added, so build_batches never splits them across
+	// chunks. Entities stay in the order they first showed up.
+	for (system_t& system : _systems)
+	{
+		std::unordered_map<const ga_entity*, int> first;
+		for (int i = 0; i < int(system._components.size()); ++i)
+		{
+			first.insert(std::make_pair(system._components[i]->get_entity(), i));
+		}
+		std::stable_sort(system._components.begin(), system._components.end(), [&first](ga_component* a, ga_component* b)
+		{
+			return first[a->get_entity()] < first[b->get_entity()];
+		});
+	}
 }
 
-void ga_sim::late_update(ga_frame_params* params)
+void ga_sim::build_batches()
 {
-	auto decls = static_cast<ga_job_decl_t*>(alloca(sizeof(ga_job_decl_t) * _entities.size()));
+	// Greedily extend the current batch while each system is independent of
+	// everything in it. A conflict starts a new batch, so systems that
+	// conflict keep their order.
+	_batches.clear();
+	uint64_t batch_reads = 0;
+	uint64_t batch_writes = 0;
+
+	for (int s = 0; s < int(_systems.size()); ++s)
+	{
+		const ga_system& system = _systems[s]._system;
+		bool conflict =
+			(system._writes & (batch_reads | batch_writes)) != 0 ||
+			(system._reads & batch_writes) != 0;
+
+		if (_batches.empty() || conflict)
+		{
+			_batches.push_back(std::vector<chunk_t>());
+			batch_reads = 0;
+			batch_writes = 0;
+		}
+		batch_reads |= system._reads;
+		batch_writes |= system._writes;
+
+		const std::vector<ga_component*>& components = _systems[s]._components;
+		if (components.empty())
+		{
+			_batches.back().push_back({ s, 0, 0 });
+		}
+		// Components of one entity write the same state, so they stay in
+		// one chunk and update in order.
+		for (int begin = 0; begin < int(components.size());)
+		{
+			int end = begin + k_component_grain < int(components.size()) ? begin + k_component_grain : int(components.size());
+			while (end < int(components.size()) && components[end]->get_entity() == components[end - 1]->get_entity())
+			{
+				end++;
+			}
+			_batches.back().push_back({ s, begin, end });
+			begin = end;
+		}
+	}
+
+	_batches_dirty = false;
+}
 
-	struct update_data_t
+void ga_sim::run_batches(ga_frame_params* params, bool late)
+{
+	struct batch_data_t
 	{
-		ga_entity* _entity;
+		ga_sim* _sim;
+		const chunk_t* _chunks;
 		ga_frame_params* _params;
+		bool _late;
 	};
-	auto update_data = static_cast<update_data_t*>(alloca(sizeof(update_data_t) * _entities.size()));
 
-	for (int i = 0; i < _entities.size(); ++i)
+	for (const std::vector<chunk_t>& batch : _batches)
 	{
-		update_data[i]._entity = _entities[i];
-		update_data[i]._params = params;
+		batch_data_t batch_data = { this, batch.data(), params, late };
+
+		ga_job::parallel_for(0, int(batch.size()), 1, [](int begin, int end, void* data)
+		{
+			auto batch_data = static_cast<batch_data_t*>(data);
+			for (int i = begin; i < end; ++i)
+			{
+				batch_data->_sim->run_chunk(batch_data->_chunks[i], batch_data->_params, batch_data->_late);
+			}
+		}, &batch_data);
+	}
+}
+
+void ga_sim::run_chunk(const chunk_t& chunk, ga_frame_params* params, bool late)
+{
+	system_t& system = _systems[chunk._system];
 
-		decls[i]._data = update_data + i;
-		decls[i]._entry = [](void* data)
+	if (system._components.empty())
+	{
+		ga_system_function_t function = late ? system._system._late_update : system._system._update;
+		if (function)
 		{
-			auto update_data = static_cast<update_data_t*>(data);
-			update_data->_entity->late_update(update_data->_params);
-		};
+			function(&_world, params, system._system._data);
+		}
+		return;
 	}
 
-	int32_t update_counter;
-	ga_job::run(decls, int(_entities.size()), &update_counter);
-	ga_job::wait(&update_counter);
+	for (int i = chunk._begin; i < chunk._end; ++i)
+	{
+		if (late)
+		{
+			system._components[i]->late_update(params);
+		}
+		else
+		{
+			system._components[i]->update(params);
+		}
+	}
 }
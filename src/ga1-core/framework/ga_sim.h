@@ -9,11 +9,42 @@
 ** This file is distributed under the MIT License. See LICENSE.txt.
 */
 
+#include "entity/ga_world.h"
+
+#include <typeindex>
+#include <unordered_map>
 #include <vector>
 
+typedef void (*ga_system_function_t)(class ga_world* world, struct ga_frame_params* params, void* data);
+
+/*
+** Work over world columns, run once per frame phase. Either function may be
+** null. reads and writes are component type masks; see ga_world::get_signature.
+*/
+struct ga_system
+{
+	const char* _name;
+	uint64_t _reads;
+	uint64_t _writes;
+	ga_system_function_t _update;
+	ga_system_function_t _late_update;
+	void* _data;
+};
+
 /*
 ** Represents the simulation stage of the frame.
-** Owns the entities.
+** Owns the entities, which live in a ga_world.
+**
+** Updates run by system rather than by entity. Each component class is a
+** system of its own, updating all its components as one parallel batch,
+** so one type's code runs at a time. Systems run in the order they were
+** added, or first seen for component types. Consecutive systems whose
+** read and write sets don't overlap run at the same time. Components of
+** one class on one entity always update on the same job, in the order
+** they were added.
+**
+** Add entities, components and systems from the main thread, between
+** frames.
 */
 class ga_sim
 {
@@ -21,11 +52,51 @@ public:
 	ga_sim();
 	~ga_sim();
 
-	void add_entity(class ga_entity* ent);
+	/* Adds a ga_entity to the world and returns its id there. */
+	ga_entity_id add_entity(class ga_entity* ent);
+
+	/* Called by entities already in the sim when they get a new component. */
+	void add_component(class ga_component* comp);
+
+	void add_system(const ga_system& system);
+
+	ga_world* get_world() { return &_world; }
 
 	void update(struct ga_frame_params* params);
 	void late_update(struct ga_frame_params* params);
 
 private:
-	std::vector<class ga_entity*> _entities;
+	struct system_t
+	{
+		ga_system _system;
+
+		// For a component class, every component of it.
+		std::vector<class ga_component*> _components;
+	};
+
+	// Part of a batch for one job: a range of a component class, or a
+	// whole world system.
+	struct chunk_t
+	{
+		int _system;
+		int _begin;
+		int _end;
+	};
+
+	void add_pending_components();
+	void build_batches();
+	void run_batches(struct ga_frame_params* params, bool late);
+	void run_chunk(const chunk_t& chunk, struct ga_frame_params* params, bool late);
+
+	ga_world _world;
+
+	std::vector<system_t> _systems;
+	std::unordered_map<std::type_index, int> _component_systems;
+
+	// Components whose class isn't known yet. A component registers from
+	// its base constructor, before the derived class exists.
+	std::vector<class ga_component*> _pending_components;
+
+	std::vector<std::vector<chunk_t>> _batches;
+	bool _batches_dirty;
 };
@@ -13,6 +13,7 @@
 #include "ga_debug_geometry.h"
 #include "ga_geometry.h"
 #include "entity/ga_entity.h"
+#include "framework/ga_profiler.h"
 
 #include <cassert>
 
@@ -34,6 +35,8 @@ ga_animation_component::~ga_animation_component()
 
 void ga_animation_component::update(ga_frame_params* params)
 {
+	GA_PROFILE_SCOPE("sim/update/ga_animation_component");
+
 	if (_playing)
 	{
 		_playing->_time += std::chrono::duration_cast<std::chrono::milliseconds>(params->_delta_time);
@@ -58,17 +61,21 @@ void ga_animation_component::update(ga_frame_params* params)
 			j->_skin = j->_inv_bind * j->_world;
 
 #if DEBUG_DRAW_SKELETON
-			ga_dynamic_drawcall drawcall;
+			ga_dynamic_drawcall drawcall(params->_arena);
 			draw_debug_sphere(0.4f, j->_world * get_entity()->get_transform(), &drawcall);
 
-			while (params->_dynamic_drawcall_lock.test_and_set(std::memory_order_acquire)) {}
-			params->_dynamic_drawcalls.push_back(drawcall);
-			params->_dynamic_drawcall_lock.clear(std::memory_order_release);
+			params->_dynamic_drawcalls.push_back(std::move(drawcall));
 #endif
 		}
 	}
 }
 
+void ga_animation_component::get_access(uint64_t* reads, uint64_t* writes) const
+{
+	*reads = ga_world::get_signature<ga_transform_state, ga_animation_state>();
+	*writes = ga_world::get_signature<ga_animation_state>();
+}
+
 void ga_animation_component::play(ga_animation* animation)
 {
 	_playing = new ga_animation_playback();
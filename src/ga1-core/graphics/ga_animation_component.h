@@ -23,6 +23,7 @@ public:
 	virtual ~ga_animation_component();
 
 	virtual void update(struct ga_frame_params* params) override;
+	virtual void get_access(uint64_t* reads, uint64_t* writes) const override;
 
 	void play(struct ga_animation* animation);
 
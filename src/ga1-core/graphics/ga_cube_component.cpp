@@ -11,6 +11,7 @@
 #include "ga_material.h"
 
 #include "entity/ga_entity.h"
+#include "framework/ga_profiler.h"
 
 #define GLEW_STATIC
 #include <GL/glew.h>
@@ -176,20 +177,27 @@ ga_cube_component::~ga_cube_component()
 
 void ga_cube_component::update(ga_frame_params* params)
 {
+	GA_PROFILE_SCOPE("sim/update/ga_cube_component");
+
 	float dt = std::chrono::duration_cast<std::chrono::duration<float>>(params->_delta_time).count();
 	ga_quatf axis_angle;
 	axis_angle.make_axis_angle(ga_vec3f::y_vector(), ga_degrees_to_radians(60.0f) * dt);
 	get_entity()->rotate(axis_angle);
 
 	ga_static_drawcall draw;
-	draw._name = "ga_cube_component";
+	static const ga_name_t k_name = ga_intern_name("ga_cube_component");
+	draw._name = k_name;
 	draw._vao = _vao;
 	draw._index_count = _index_count;
 	draw._transform = get_entity()->get_transform();
 	draw._draw_mode = GL_TRIANGLES;
 	draw._material = _material;
 
-	while (params->_static_drawcall_lock.test_and_set(std::memory_order_acquire)) {}
-	params->_static_drawcalls.push_back(draw);
-	params->_static_drawcall_lock.clear(std::memory_order_release);
+	params->_static_drawcalls.push_back(std::move(draw));
+}
+
+void ga_cube_component::get_access(uint64_t* reads, uint64_t* writes) const
+{
+	*reads = ga_world::get_signature<ga_transform_state>();
+	*writes = ga_world::get_signature<ga_transform_state>();
 }
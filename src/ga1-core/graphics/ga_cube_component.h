@@ -23,6 +23,7 @@ public:
 	virtual ~ga_cube_component();
 
 	virtual void update(struct ga_frame_params* params) override;
+	virtual void get_access(uint64_t* reads, uint64_t* writes) const override;
 
 private:
 	class ga_material* _material;
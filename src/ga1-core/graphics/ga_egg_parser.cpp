@@ -11,19 +11,20 @@
 
 #include "ga_animation.h"
 #include "ga_geometry.h"
+#include "jobs/ga_io.h"
 
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
-#include <fstream>
 #include <iostream>
 #include <istream>
+#include <sstream>
 
-void parse_texture_data(std::ifstream &file, struct ga_model* model);
-void parse_vertex_data(std::ifstream &file, struct ga_model* model);
-void parse_poly_data(std::ifstream &file, struct ga_model* model);
-void parse_joint_data(std::ifstream &file, struct ga_model* model, uint32_t depth = 0);
-void parse_joint_anim_data(std::ifstream &file, struct ga_animation* animation, uint32_t depth = 0);
+void parse_texture_data(std::istream &file, struct ga_model* model);
+void parse_vertex_data(std::istream &file, struct ga_model* model);
+void parse_poly_data(std::istream &file, struct ga_model* model);
+void parse_joint_data(std::istream &file, struct ga_model* model, uint32_t depth = 0);
+void parse_joint_anim_data(std::istream &file, struct ga_animation* animation, uint32_t depth = 0);
 
 void egg_to_model(const char* filename, ga_model* model)
 {
@@ -31,7 +32,10 @@ void egg_to_model(const char* filename, ga_model* model)
 	std::string fullpath = g_root_path;
 	fullpath += filename;
 
-	std::ifstream file(fullpath);
+	// Read the whole file up front so a job loading it doesn't block a worker.
+	std::string contents;
+	ga_io::read_file(fullpath.c_str(), contents);
+	std::istringstream file(contents);
 
 	char data[128];
 	file >> data;
@@ -60,7 +64,7 @@ void egg_to_model(const char* filename, ga_model* model)
 	}
 }
 
-void parse_texture_data(std::ifstream &file, ga_model* model)
+void parse_texture_data(std::istream &file, ga_model* model)
 {
 	char data[128];
 	file >> data;
@@ -87,7 +91,7 @@ void parse_texture_data(std::ifstream &file, ga_model* model)
 	}
 }
 
-void parse_vertex_data(std::ifstream &file, ga_model* model)
+void parse_vertex_data(std::istream &file, ga_model* model)
 {
 	ga_vertex v;
 
@@ -148,7 +152,7 @@ void parse_vertex_data(std::ifstream &file, ga_model* model)
 	model->_vertices.push_back(v);
 }
 
-void parse_poly_data(std::ifstream &file, ga_model* model)
+void parse_poly_data(std::istream &file, ga_model* model)
 {
 	int vertex_count = 0;
 	uint32_t indices[4];
@@ -198,7 +202,7 @@ void parse_poly_data(std::ifstream &file, ga_model* model)
 	}
 }
 
-void parse_joint_data(std::ifstream &file, ga_model* model, uint32_t depth)
+void parse_joint_data(std::istream &file, ga_model* model, uint32_t depth)
 {
 	ga_joint* j = new ga_joint;
 	j->_parent = depth > 0 ? depth - 1 : INT_MAX;
@@ -307,11 +311,13 @@ void parse_joint_data(std::ifstream &file, ga_model* model, uint32_t depth)
 
 void egg_to_animation(const char* filename, ga_animation* animation)
 {
-	std::ifstream file;
 	extern char g_root_path[256];
 	std::string fullpath = g_root_path;
 	fullpath += filename;
-	file.open(fullpath);
+
+	std::string contents;
+	ga_io::read_file(fullpath.c_str(), contents);
+	std::istringstream file(contents);
 	
 	char data[128];
 	file >> data;
@@ -344,7 +350,7 @@ void egg_to_animation(const char* filename, ga_animation* animation)
 	}
 }
 
-void parse_joint_anim_data(std::ifstream& file, ga_animation* animation, uint32_t depth)
+void parse_joint_anim_data(std::istream& file, ga_animation* animation, uint32_t depth)
 {
 	char data[128];
 	int open_parens = 0;
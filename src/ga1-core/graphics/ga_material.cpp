@@ -10,23 +10,24 @@
 #include "ga_material.h"
 
 #include "ga_animation.h"
+#include "jobs/ga_io.h"
 
 #include <cassert>
-#include <fstream>
 #include <iostream>
 #include <string>
 
-void load_shader(const char* filename, std::string& contents)
+static bool load_shader(const char* filename, std::string& contents)
 {
 	extern char g_root_path[256];
 	std::string fullpath = g_root_path;
 	fullpath += filename;
 
-	std::ifstream file(fullpath);
-
-	assert(file.is_open());
-
-	contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	if (!ga_io::read_file(fullpath.c_str(), contents))
+	{
+		std::cerr << "Failed to load shader " << fullpath << std::endl;
+		return false;
+	}
+	return true;
 }
 
 ga_unlit_texture_material::ga_unlit_texture_material(const char* texture_file) :
@@ -41,10 +42,12 @@ ga_unlit_texture_material::~ga_unlit_texture_material()
 bool ga_unlit_texture_material::init()
 {
 	std::string source_vs;
-	load_shader("data/shaders/ga_unlit_texture_vert.glsl", source_vs);
-
 	std::string source_fs;
-	load_shader("data/shaders/ga_unlit_texture_frag.glsl", source_fs);
+	if (!load_shader("data/shaders/ga_unlit_texture_vert.glsl", source_vs) ||
+		!load_shader("data/shaders/ga_unlit_texture_frag.glsl", source_fs))
+	{
+		return false;
+	}
 
 	_vs = new ga_shader(source_vs.c_str(), GL_VERTEX_SHADER);
 	if (!_vs->compile())
@@ -101,10 +104,12 @@ ga_constant_color_material::~ga_constant_color_material()
 bool ga_constant_color_material::init()
 {
 	std::string source_vs;
-	load_shader("data/shaders/ga_constant_color_vert.glsl", source_vs);
-
 	std::string source_fs;
-	load_shader("data/shaders/ga_constant_color_frag.glsl", source_fs);
+	if (!load_shader("data/shaders/ga_constant_color_vert.glsl", source_vs) ||
+		!load_shader("data/shaders/ga_constant_color_frag.glsl", source_fs))
+	{
+		return false;
+	}
 
 	_vs = new ga_shader(source_vs.c_str(), GL_VERTEX_SHADER);
 	if (!_vs->compile())
@@ -155,10 +160,12 @@ ga_animated_material::~ga_animated_material()
 bool ga_animated_material::init()
 {
 	std::string source_vs;
-	load_shader("data/shaders/ga_animated_vert.glsl", source_vs);
-
 	std::string source_fs;
-	load_shader("data/shaders/ga_animated_frag.glsl", source_fs);
+	if (!load_shader("data/shaders/ga_animated_vert.glsl", source_vs) ||
+		!load_shader("data/shaders/ga_animated_frag.glsl", source_fs))
+	{
+		return false;
+	}
 
 	_vs = new ga_shader(source_vs.c_str(), GL_VERTEX_SHADER);
 	if (!_vs->compile())
@@ -192,12 +199,24 @@ void ga_animated_material::bind(const ga_mat4f& view_proj, const ga_mat4f& trans
 
 	mvp_uniform.set(transform * view_proj);
 	
-	// Collect the skinning matrices.
+	// Collect the skinning matrices. Prefer those captured with the draw,
+	// since the sim may already be posing the skeleton for the next frame.
 	ga_mat4f skin[ga_skeleton::k_max_skeleton_joints];
-	for (uint32_t i = 0; i < _skeleton->_joints.size(); ++i)
+	if (_skin)
+	{
+		assert(_skin_count <= ga_skeleton::k_max_skeleton_joints);
+		for (uint32_t i = 0; i < _skin_count; ++i)
+		{
+			skin[i] = _skin[i];
+		}
+	}
+	else
 	{
-		assert(i < ga_skeleton::k_max_skeleton_joints);
-		skin[i] = _skeleton->_joints[i]->_skin;
+		for (uint32_t i = 0; i < _skeleton->_joints.size(); ++i)
+		{
+			assert(i < ga_skeleton::k_max_skeleton_joints);
+			skin[i] = _skeleton->_joints[i]->_skin;
+		}
 	}
 	skin_uniform.set(skin, ga_skeleton::k_max_skeleton_joints);
 
@@ -29,6 +29,9 @@ public:
 	virtual void bind(const ga_mat4f& view_proj, const ga_mat4f& transform) = 0;
 
 	virtual void set_color(const ga_vec3f& color) {}
+
+	// Skinning matrices for the next bind, captured with the draw.
+	virtual void set_skin(const ga_mat4f* skin, uint32_t count) {}
 };
 
 /*
@@ -87,10 +90,15 @@ public:
 	virtual bool init() override;
 	virtual void bind(const ga_mat4f& view_proj, const ga_mat4f& transform) override;
 
+	virtual void set_skin(const ga_mat4f* skin, uint32_t count) override { _skin = skin; _skin_count = count; }
+
 private:
 	ga_shader* _vs;
 	ga_shader* _fs;
 	ga_program* _program;
 
 	struct ga_skeleton* _skeleton;
+
+	const ga_mat4f* _skin = 0;
+	uint32_t _skin_count = 0;
 };
@@ -14,12 +14,15 @@
 #include "ga_material.h"
 
 #include "entity/ga_entity.h"
+#include "framework/ga_frame_params.h"
+#include "framework/ga_profiler.h"
 
 #define GLEW_STATIC
 #include <GL/glew.h>
 
 ga_model_component::ga_model_component(ga_entity* ent, ga_model* model) : ga_component(ent)
 {
+	_skeleton = model->_skeleton;
 	_material = new ga_animated_material(model->_skeleton);
 	_material->init();
 
@@ -82,15 +85,36 @@ ga_model_component::~ga_model_component()
 
 void ga_model_component::update(ga_frame_params* params)
 {
+	GA_PROFILE_SCOPE("sim/update/ga_model_component");
+
 	ga_static_drawcall draw;
-	draw._name = "ga_animated_model_component";
+	static const ga_name_t k_name = ga_intern_name("ga_animated_model_component");
+	draw._name = k_name;
 	draw._vao = _vao;
 	draw._index_count = _index_count;
 	draw._transform = get_entity()->get_transform();
 	draw._draw_mode = GL_TRIANGLES;
 	draw._material = _material;
 
-	while (params->_static_drawcall_lock.test_and_set(std::memory_order_acquire)) {}
-	params->_static_drawcalls.push_back(draw);
-	params->_static_drawcall_lock.clear(std::memory_order_release);
+	// Output may run while the next frame poses the skeleton, so it draws
+	// from a copy of this frame's skin.
+	if (_skeleton)
+	{
+		uint32_t count = uint32_t(_skeleton->_joints.size());
+		ga_mat4f* skin = static_cast<ga_mat4f*>(params->_arena->alloc(sizeof(ga_mat4f) * count, alignof(ga_mat4f)));
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			skin[i] = _skeleton->_joints[i]->_skin;
+		}
+		draw._skin = skin;
+		draw._skin_count = count;
+	}
+
+	params->_static_drawcalls.push_back(std::move(draw));
+}
+
+void ga_model_component::get_access(uint64_t* reads, uint64_t* writes) const
+{
+	*reads = ga_world::get_signature<ga_transform_state, ga_animation_state>();
+	*writes = 0;
 }
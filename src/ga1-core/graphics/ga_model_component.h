@@ -23,9 +23,11 @@ public:
 	virtual ~ga_model_component();
 
 	virtual void update(struct ga_frame_params* params) override;
+	virtual void get_access(uint64_t* reads, uint64_t* writes) const override;
 
 private:
 	class ga_material* _material;
+	struct ga_skeleton* _skeleton;
 	uint32_t _vao;
 	uint32_t _vbos[4];
 	uint32_t _index_count;
@@ -9,6 +9,8 @@
 
 #include "ga_texture.h"
 
+#include "jobs/ga_io.h"
+
 #include <stb_image.h>
 #include <string>
 
@@ -38,8 +40,14 @@ bool ga_texture::load_from_file(const char* path)
 	std::string fullpath = g_root_path;
 	fullpath += path;
 
+	std::string contents;
+	if (!ga_io::read_file(fullpath.c_str(), contents))
+	{
+		return false;
+	}
+
 	int width, height, channels_in_file;
-	uint8_t* data = stbi_load(fullpath.c_str(), &width, &height, &channels_in_file, 4);
+	uint8_t* data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(contents.data()), int(contents.size()), &width, &height, &channels_in_file, 4);
 	if (!data)
 	{
 		return false;
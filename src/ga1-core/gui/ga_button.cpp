@@ -69,5 +69,5 @@ bool ga_button::get_pressed(const ga_frame_params* params) const
 
 bool ga_button::get_clicked(const ga_frame_params* params) const
 {
-	return params->_mouse_click_mask != 0 && get_hover(params);
+	return get_clicked_inside(params, _min, _max);
 }
@@ -49,5 +49,5 @@ bool ga_checkbox::get_pressed(const ga_frame_params* params) const
 
 bool ga_checkbox::get_clicked(const ga_frame_params* params) const
 {
-	return params->_mouse_click_mask != 0 && get_hover(params);
+	return get_clicked_inside(params, _min, _max);
 }
@@ -14,6 +14,7 @@
 #include "math/ga_vec2f.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 
 #if defined(GA_MINGW)
@@ -94,12 +95,17 @@ void ga_font::print(
 		*max = { x, y };
 	}
 
-	ga_dynamic_drawcall drawcall;
+	ga_dynamic_drawcall drawcall(params->_arena);
 	drawcall._color = color;
 	drawcall._draw_mode = GL_TRIANGLES;
 	drawcall._material = _material;
 	drawcall._transform.make_identity();
 
+	size_t length = strlen(text);
+	drawcall._positions.reserve(length * 4);
+	drawcall._texcoords.reserve(length * 4);
+	drawcall._indices.reserve(length * 6);
+
 	int index = 0;
 	while (*text)
 	{
@@ -140,9 +146,7 @@ void ga_font::print(
 		++text;
 	}
 
-	while (params->_gui_drawcall_lock.test_and_set(std::memory_order_acquire)) {}
-	params->_gui_drawcalls.push_back(drawcall);
-	params->_gui_drawcall_lock.clear(std::memory_order_release);
+	params->_gui_drawcalls.push_back(std::move(drawcall));
 }
 
 ga_font_material::ga_font_material(ga_texture* texture) : _texture(texture)
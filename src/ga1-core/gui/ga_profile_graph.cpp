@@ -0,0 +1,134 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_profile_graph.h"
+#include "ga_font.h"
+
+#include "framework/ga_frame_params.h"
+#include "framework/ga_profiler.h"
+
+#include <cstdio>
+#include <cstring>
+
+// Graph scale: bar width in pixels, and the frame time at full height.
+static const float k_bar_width = 2.0f;
+static const float k_graph_height = 100.0f;
+static const double k_graph_ms = 33.3;
+static const double k_budget_ms = 1000.0 / 60.0;
+
+static const float k_line_height = 24.0f;
+
+static double to_ms(std::chrono::steady_clock::duration time)
+{
+	return std::chrono::duration<double, std::milli>(time).count();
+}
+
+ga_profile_graph::ga_profile_graph(float x, float y, ga_frame_params* params)
+{
+	extern ga_font* g_font_alt;
+
+	int history_count = ga_profiler::get_history_count();
+	if (history_count == 0)
+	{
+		return;
+	}
+
+	// Bars within budget in one drawcall, those over in another, oldest
+	// frame on the left.
+	ga_dynamic_drawcall bars[2] = { ga_dynamic_drawcall(params->_arena), ga_dynamic_drawcall(params->_arena) };
+	for (auto& b : bars)
+	{
+		b._positions.reserve(history_count * 4);
+		b._indices.reserve(history_count * 6);
+		b._draw_mode = GL_TRIANGLES;
+		b._transform.make_identity();
+		b._material = nullptr;
+	}
+	bars[0]._color = { 0.25f, 1.0f, 0.25f };
+	bars[1]._color = { 1.0f, 0.25f, 0.25f };
+
+	float bottom = y + k_graph_height;
+	for (int age = history_count - 1; age >= 0; --age)
+	{
+		double ms = to_ms(ga_profiler::get_frame_time(age));
+		float height = float(ms < k_graph_ms ? ms : k_graph_ms) / float(k_graph_ms) * k_graph_height;
+		float left = x + k_bar_width * (history_count - 1 - age);
+
+		ga_dynamic_drawcall& b = bars[ms > k_budget_ms ? 1 : 0];
+		uint16_t base = uint16_t(b._positions.size());
+		b._positions.push_back({ left, bottom - height, 0.0f });
+		b._positions.push_back({ left + k_bar_width, bottom - height, 0.0f });
+		b._positions.push_back({ left + k_bar_width, bottom, 0.0f });
+		b._positions.push_back({ left, bottom, 0.0f });
+		b._indices.push_back(base + 0);
+		b._indices.push_back(base + 1);
+		b._indices.push_back(base + 2);
+		b._indices.push_back(base + 0);
+		b._indices.push_back(base + 3);
+		b._indices.push_back(base + 2);
+	}
+	for (auto& b : bars)
+	{
+		if (!b._indices.empty())
+		{
+			params->_gui_drawcalls.push_back(std::move(b));
+		}
+	}
+
+	// Budget line across the graph.
+	float budget_y = bottom - float(k_budget_ms / k_graph_ms) * k_graph_height;
+	ga_dynamic_drawcall budget(params->_arena);
+	budget._positions.reserve(2);
+	budget._indices.reserve(2);
+	budget._positions.push_back({ x, budget_y, 0.0f });
+	budget._positions.push_back({ x + k_bar_width * history_count, budget_y, 0.0f });
+	budget._indices.push_back(0);
+	budget._indices.push_back(1);
+	budget._color = k_text_color;
+	budget._draw_mode = GL_LINES;
+	budget._transform.make_identity();
+	budget._material = nullptr;
+	params->_gui_drawcalls.push_back(std::move(budget));
+
+	// Table of mean and peak per marker over the history.
+	char line[128];
+	float text_y = bottom + k_line_height * 1.5f;
+	snprintf(line, sizeof(line), "%-24s %7s %7s", "ms", "mean", "peak");
+	g_font_alt->print(params, line, x, text_y, k_text_color);
+
+	int marker_count = ga_profiler::get_marker_count();
+	for (int m = -1; m < marker_count; ++m)
+	{
+		double total = 0.0;
+		double peak = 0.0;
+		for (int age = 0; age < history_count; ++age)
+		{
+			double ms = to_ms(m < 0 ? ga_profiler::get_frame_time(age) : ga_profiler::get_marker_time(m, age));
+			total += ms;
+			peak = ms > peak ? ms : peak;
+		}
+
+		// Indent by depth and show only the last part of the name.
+		const char* name = m < 0 ? "frame" : ga_profiler::get_marker_name(m);
+		int depth = 0;
+		for (const char* c = strchr(name, '/'); c; c = strchr(c + 1, '/'))
+		{
+			name = c + 1;
+			depth++;
+		}
+
+		snprintf(line, sizeof(line), "%*s%-*s %7.2f %7.2f", depth * 2, "", 24 - depth * 2, name, total / history_count, peak);
+		text_y += k_line_height;
+		g_font_alt->print(params, line, x, text_y, k_text_color);
+	}
+}
+
+ga_profile_graph::~ga_profile_graph()
+{
+}
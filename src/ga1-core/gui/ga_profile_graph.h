@@ -0,0 +1,23 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_widget.h"
+
+/*
+** GUI overlay of the profiler history. A bar per frame, red past 60 Hz,
+** then the mean and peak of each marker, indented by nesting.
+*/
+class ga_profile_graph : public ga_widget
+{
+public:
+	ga_profile_graph(float x, float y, struct ga_frame_params* params);
+	~ga_profile_graph();
+};
@@ -11,6 +11,7 @@
 
 #include "framework/ga_drawcall.h"
 #include "framework/ga_frame_params.h"
+#include "framework/ga_input_ring.h"
 
 const ga_vec3f ga_widget::k_button_color = { 0.25f, 0.25f, 1.0f };
 const ga_vec3f ga_widget::k_button_hover_color = { 0.75f, 0.75f, 1.0f };
@@ -21,7 +22,9 @@ const float ga_widget::k_checkbox_offset = 64.0f;
 
 void ga_widget::draw_outline(ga_frame_params* params, const ga_vec2f& min, const ga_vec2f& max, const ga_vec3f& color, float offset)
 {
-	ga_dynamic_drawcall drawcall;
+	ga_dynamic_drawcall drawcall(params->_arena);
+	drawcall._positions.reserve(4);
+	drawcall._indices.reserve(8);
 
 	drawcall._positions.push_back({ min.x - offset, min.y - offset, 0.0f });
 	drawcall._positions.push_back({ max.x + offset, min.y - offset, 0.0f });
@@ -42,14 +45,14 @@ void ga_widget::draw_outline(ga_frame_params* params, const ga_vec2f& min, const
 	drawcall._transform.make_identity();
 	drawcall._material = nullptr;
 
-	while (params->_gui_drawcall_lock.test_and_set(std::memory_order_acquire)) {}
-	params->_gui_drawcalls.push_back(drawcall);
-	params->_gui_drawcall_lock.clear(std::memory_order_release);
+	params->_gui_drawcalls.push_back(std::move(drawcall));
 }
 
 void ga_widget::draw_check(ga_frame_params* params, const ga_vec2f& min, const ga_vec2f& max, const ga_vec3f& color)
 {
-	ga_dynamic_drawcall drawcall;
+	ga_dynamic_drawcall drawcall(params->_arena);
+	drawcall._positions.reserve(4);
+	drawcall._indices.reserve(4);
 
 	drawcall._positions.push_back({ min.x, min.y, 0.0f });
 	drawcall._positions.push_back({ max.x, min.y, 0.0f });
@@ -66,14 +69,14 @@ void ga_widget::draw_check(ga_frame_params* params, const ga_vec2f& min, const g
 	drawcall._transform.make_identity();
 	drawcall._material = nullptr;
 
-	while (params->_gui_drawcall_lock.test_and_set(std::memory_order_acquire)) {}
-	params->_gui_drawcalls.push_back(drawcall);
-	params->_gui_drawcall_lock.clear(std::memory_order_release);
+	params->_gui_drawcalls.push_back(std::move(drawcall));
 }
 
 void ga_widget::draw_fill(ga_frame_params* params, const ga_vec2f& min, const ga_vec2f& max, const ga_vec3f& color)
 {
-	ga_dynamic_drawcall drawcall;
+	ga_dynamic_drawcall drawcall(params->_arena);
+	drawcall._positions.reserve(4);
+	drawcall._indices.reserve(6);
 
 	drawcall._positions.push_back({ min.x, min.y, 0.0f });
 	drawcall._positions.push_back({ max.x, min.y, 0.0f });
@@ -92,7 +95,33 @@ void ga_widget::draw_fill(ga_frame_params* params, const ga_vec2f& min, const ga
 	drawcall._transform.make_identity();
 	drawcall._material = nullptr;
 
-	while (params->_gui_drawcall_lock.test_and_set(std::memory_order_acquire)) {}
-	params->_gui_drawcalls.push_back(drawcall);
-	params->_gui_drawcall_lock.clear(std::memory_order_release);
+	params->_gui_drawcalls.push_back(std::move(drawcall));
+}
+
+bool ga_widget::get_clicked_inside(const ga_frame_params* params, const ga_vec2f& min, const ga_vec2f& max) const
+{
+	if (!params->_input_events)
+	{
+		return
+			params->_mouse_click_mask != 0 &&
+			min.x <= params->_mouse_x &&
+			min.y <= params->_mouse_y &&
+			max.x >= params->_mouse_x &&
+			max.y >= params->_mouse_y;
+	}
+
+	for (uint64_t i = params->_input_event_begin; i < params->_input_event_end; ++i)
+	{
+		ga_input_event event;
+		if (params->_input_events->get(i, &event) &&
+			event._type == k_input_mouse_up &&
+			min.x <= event._x &&
+			min.y <= event._y &&
+			max.x >= event._x &&
+			max.y >= event._y)
+		{
+			return true;
+		}
+	}
+	return false;
 }
@@ -27,4 +27,8 @@ protected:
 	void draw_outline(struct ga_frame_params* params, const struct ga_vec2f& min, const struct ga_vec2f& max, const struct ga_vec3f& color, float offset);
 	void draw_check(struct ga_frame_params* params, const struct ga_vec2f& min, const struct ga_vec2f& max, const struct ga_vec3f& color);
 	void draw_fill(struct ga_frame_params* params, const struct ga_vec2f& min, const struct ga_vec2f& max, const struct ga_vec3f& color);
+
+	// True if a mouse button was released inside the box this frame, going
+	// by where the mouse was at the time rather than at the end of the frame.
+	bool get_clicked_inside(const struct ga_frame_params* params, const struct ga_vec2f& min, const struct ga_vec2f& max) const;
 };
@@ -0,0 +1,322 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+/*
+** Headless simulation runner.
+** Drives ga_sim, physics and Lua at a fixed timestep with no window, GL
+** context or audio, as fast as it can, then reports ticks per second and
+** the time spent in each stage. For CI and machines without a display.
+**
+** Usage: ga_headless [-ticks N] [-hz N] [-bodies N] [-scripts N] [-csv path] [-replay path]
+**
+** -csv enables the profiler and writes its markers for the last ticks.
+** -replay feeds each tick the input and delta time of a frame recorded with
+** ga -record, until the log runs out or -ticks is reached.
+*/
+
+#include "framework/ga_frame_params.h"
+#include "framework/ga_input_log.h"
+#include "framework/ga_profiler.h"
+#include "framework/ga_sim.h"
+#include "jobs/ga_cpu_topology.h"
+#include "jobs/ga_frame_arena.h"
+#include "jobs/ga_io.h"
+#include "jobs/ga_job.h"
+
+#include "entity/ga_entity.h"
+#include "entity/ga_lua_component.h"
+
+#include "physics/ga_physics_component.h"
+#include "physics/ga_physics_world.h"
+#include "physics/ga_rigid_body.h"
+#include "physics/ga_shape.h"
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+typedef std::chrono::high_resolution_clock ga_headless_clock_t;
+
+// Stages of a tick, timed separately.
+enum headless_stage_t
+{
+	k_stage_input,
+	k_stage_update,
+	k_stage_physics,
+	k_stage_late_update,
+	k_stage_count,
+};
+
+static const char* k_stage_names[k_stage_count] =
+{
+	"input",
+	"update",
+	"physics",
+	"late_update",
+};
+
+struct stage_stats_t
+{
+	ga_headless_clock_t::duration _total = ga_headless_clock_t::duration::zero();
+	ga_headless_clock_t::duration _max = ga_headless_clock_t::duration::zero();
+};
+
+static void set_root_path(const char* exepath);
+
+int main(int argc, const char** argv)
+{
+	set_root_path(argv[0]);
+
+	int tick_count = -1;
+	int tick_rate = 60;
+	int body_count = 256;
+	int script_count = 16;
+	const char* csv_path = nullptr;
+	const char* replay_path = nullptr;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-ticks") == 0 && i + 1 < argc)
+		{
+			tick_count = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-hz") == 0 && i + 1 < argc)
+		{
+			tick_rate = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-bodies") == 0 && i + 1 < argc)
+		{
+			body_count = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-scripts") == 0 && i + 1 < argc)
+		{
+			script_count = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-csv") == 0 && i + 1 < argc)
+		{
+			csv_path = argv[++i];
+		}
+		else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc)
+		{
+			replay_path = argv[++i];
+		}
+		else
+		{
+			fprintf(stderr, "Unknown or incomplete option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	ga_input_player player;
+	if (replay_path && !player.open(replay_path))
+	{
+		fprintf(stderr, "Failed to open input log %s\n", replay_path);
+		return 1;
+	}
+	if (tick_count < 0)
+	{
+		tick_count = replay_path ? INT_MAX : 10000;
+	}
+
+	ga_cpu_topology topology;
+	ga_job_config job_config;
+	job_config._worker_cpus = topology.get_physical_cores();
+	ga_job::startup(job_config);
+	ga_io::startup();
+
+	ga_profiler::startup();
+	ga_profiler::set_enabled(csv_path != nullptr);
+
+	ga_sim* sim = new ga_sim();
+	ga_physics_world* world = new ga_physics_world();
+
+	// A static floor with a grid of spheres dropped onto it.
+	ga_plane floor_shape;
+	floor_shape._point = { 0.0f, 0.0f, 0.0f };
+	floor_shape._normal = { 0.0f, 1.0f, 0.0f };
+
+	ga_entity floor;
+	ga_physics_component floor_physics(&floor, &floor_shape, 0.0f);
+	floor_physics.get_rigid_body()->make_static();
+	world->add_rigid_body(floor_physics.get_rigid_body());
+	sim->add_entity(&floor);
+
+	ga_sphere sphere_shape;
+	sphere_shape._center = { 0.0f, 0.0f, 0.0f };
+	sphere_shape._radius = 0.5f;
+
+	std::vector<ga_entity*> entities;
+	std::vector<ga_component*> components;
+
+	int side = 1;
+	while (side * side < body_count)
+	{
+		side++;
+	}
+	for (int i = 0; i < body_count; ++i)
+	{
+		ga_entity* ent = new ga_entity();
+		ent->translate({ 1.5f * (i % side), 2.0f + (i % 7), 1.5f * (i / side) });
+
+		ga_physics_component* physics = new ga_physics_component(ent, &sphere_shape, 1.0f);
+		world->add_rigid_body(physics->get_rigid_body());
+
+		entities.push_back(ent);
+		components.push_back(physics);
+		sim->add_entity(ent);
+	}
+
+	for (int i = 0; i < script_count; ++i)
+	{
+		ga_entity* ent = new ga_entity();
+		ga_lua_component* lua = new ga_lua_component(ent, "data/scripts/move.lua");
+
+		entities.push_back(ent);
+		components.push_back(lua);
+		sim->add_entity(ent);
+	}
+
+	// Ticks are fixed in sim time, however long they take on the wall clock.
+	const ga_headless_clock_t::duration dt = std::chrono::duration_cast<ga_headless_clock_t::duration>(
+		std::chrono::duration<double>(1.0 / tick_rate));
+	ga_headless_clock_t::time_point sim_time;
+
+	stage_stats_t stats[k_stage_count];
+	ga_frame_arena arena;
+
+	int ticks = 0;
+	auto start = ga_headless_clock_t::now();
+	for (; ticks < tick_count; ++ticks)
+	{
+		auto t0 = ga_headless_clock_t::now();
+
+		arena.reset();
+		ga_frame_params* params = new (arena.alloc(sizeof(ga_frame_params), alignof(ga_frame_params))) ga_frame_params(&arena);
+
+		ga_job::begin_frame();
+		ga_profiler::begin_frame();
+
+		// No devices; input is the clock and nothing held, or a recording.
+		params->_delta_time = dt;
+		params->_button_mask = 0;
+		params->_mouse_click_mask = 0;
+		params->_mouse_press_mask = 0;
+		params->_mouse_x = 0.0f;
+		params->_mouse_y = 0.0f;
+		params->_view.make_identity();
+		if (replay_path && !player.play(params))
+		{
+			params->~ga_frame_params();
+			break;
+		}
+		sim_time += params->_delta_time;
+		params->_current_time = sim_time;
+
+		auto t1 = ga_headless_clock_t::now();
+		sim->update(params);
+		auto t2 = ga_headless_clock_t::now();
+		world->step(params);
+		auto t3 = ga_headless_clock_t::now();
+		sim->late_update(params);
+		auto t4 = ga_headless_clock_t::now();
+
+		// Drawcalls were emitted as usual and are dropped here.
+		params->~ga_frame_params();
+
+		ga_headless_clock_t::duration times[k_stage_count] = { t1 - t0, t2 - t1, t3 - t2, t4 - t3 };
+		for (int s = 0; s < k_stage_count; ++s)
+		{
+			stats[s]._total += times[s];
+			if (times[s] > stats[s]._max)
+			{
+				stats[s]._max = times[s];
+			}
+		}
+	}
+	auto end = ga_headless_clock_t::now();
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+	if (replay_path)
+	{
+		printf("%d ticks replayed from %s, %.3f s of sim time, %d bodies, %d scripts: %.3f s, %.1f ticks/s\n",
+			ticks, replay_path, std::chrono::duration<double>(sim_time.time_since_epoch()).count(),
+			body_count, script_count, seconds, ticks / seconds);
+	}
+	else
+	{
+		printf("%d ticks at %d Hz, %d bodies, %d scripts: %.3f s, %.1f ticks/s\n",
+			ticks, tick_rate, body_count, script_count, seconds, ticks / seconds);
+	}
+	printf("%12s %12s %12s\n", "stage", "mean us", "max us");
+	for (int s = 0; s < k_stage_count && ticks > 0; ++s)
+	{
+		printf("%12s %12.2f %12.2f\n", k_stage_names[s],
+			std::chrono::duration<double, std::micro>(stats[s]._total).count() / ticks,
+			std::chrono::duration<double, std::micro>(stats[s]._max).count());
+	}
+
+	if (csv_path)
+	{
+		// Close out the last tick first.
+		ga_profiler::begin_frame();
+		if (!ga_profiler::write_csv(csv_path))
+		{
+			fprintf(stderr, "Failed to write %s\n", csv_path);
+		}
+	}
+
+	for (int i = 0; i < body_count; ++i)
+	{
+		world->remove_rigid_body(static_cast<ga_physics_component*>(components[i])->get_rigid_body());
+	}
+	world->remove_rigid_body(floor_physics.get_rigid_body());
+
+	for (auto c : components)
+	{
+		delete c;
+	}
+	for (auto e : entities)
+	{
+		delete e;
+	}
+	delete world;
+	delete sim;
+
+	ga_profiler::shutdown();
+	ga_io::shutdown();
+	ga_job::shutdown();
+
+	return 0;
+}
+
+char g_root_path[256];
+static void set_root_path(const char* exepath)
+{
+	// Data sits next to the executable.
+	strncpy(g_root_path, exepath, sizeof(g_root_path) - 1);
+	g_root_path[sizeof(g_root_path) - 1] = '\0';
+
+	char* slash = strrchr(g_root_path, '\\');
+	char* fwd_slash = strrchr(g_root_path, '/');
+	if (!slash || (fwd_slash && fwd_slash > slash))
+	{
+		slash = fwd_slash;
+	}
+	if (slash)
+	{
+		slash[1] = '\0';
+	}
+	else
+	{
+		g_root_path[0] = '\0';
+	}
+}
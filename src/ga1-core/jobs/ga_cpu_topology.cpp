@@ -0,0 +1,225 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_cpu_topology.h"
+
+#include "framework/ga_compiler_defines.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+#if defined(GA_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(GA_MSVC) || defined(GA_MINGW)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#undef WIN32_LEAN_AND_MEAN
+#endif
+
+#if defined(GA_LINUX)
+
+/* Reads a sysfs file into buffer. Returns false if it doesn't exist. */
+static bool _ga_cpu_read_file(const char* path, char* buffer, int size)
+{
+	FILE* file = fopen(path, "r");
+	if (!file)
+	{
+		return false;
+	}
+
+	int length = int(fread(buffer, 1, size - 1, file));
+	buffer[length > 0 ? length : 0] = 0;
+	fclose(file);
+	return length > 0;
+}
+
+/* Parses a CPU list such as "0-3,8,10-11". */
+static std::vector<int> _ga_cpu_parse_list(const char* list)
+{
+	std::vector<int> cpus;
+	const char* p = list;
+	while (*p)
+	{
+		int first, last, length;
+		if (sscanf(p, "%d%n", &first, &length) != 1)
+		{
+			++p;
+			continue;
+		}
+		p += length;
+
+		last = first;
+		if (*p == '-' && sscanf(p + 1, "%d%n", &last, &length) == 1)
+		{
+			p += length + 1;
+		}
+
+		for (int cpu = first; cpu <= last; ++cpu)
+		{
+			cpus.push_back(cpu);
+		}
+	}
+	return cpus;
+}
+
+/* Lowest CPU in the list in a sysfs file, or -1. */
+static int _ga_cpu_read_first(const char* path)
+{
+	char buffer[4096];
+	if (!_ga_cpu_read_file(path, buffer, sizeof(buffer)))
+	{
+		return -1;
+	}
+	std::vector<int> cpus = _ga_cpu_parse_list(buffer);
+	return cpus.empty() ? -1 : *std::min_element(cpus.begin(), cpus.end());
+}
+
+static int _ga_cpu_read_int(const char* path)
+{
+	char buffer[64];
+	int value;
+	if (!_ga_cpu_read_file(path, buffer, sizeof(buffer)) || sscanf(buffer, "%d", &value) != 1)
+	{
+		return -1;
+	}
+	return value;
+}
+
+ga_cpu_topology::ga_cpu_topology()
+{
+	char buffer[4096];
+	char path[256];
+
+	std::vector<int> online;
+	if (_ga_cpu_read_file("/sys/devices/system/cpu/online", buffer, sizeof(buffer)))
+	{
+		online = _ga_cpu_parse_list(buffer);
+	}
+
+	/* Containers and taskset restrict us to a subset. Sized for any count. */
+	int set_cpus = online.empty() ? 1024 : std::max(1024, online.back() + 1);
+	cpu_set_t* affinity = CPU_ALLOC(set_cpus);
+	size_t affinity_size = CPU_ALLOC_SIZE(set_cpus);
+	bool has_affinity = sched_getaffinity(0, affinity_size, affinity) == 0;
+
+	for (int cpu : online)
+	{
+		if (has_affinity && !CPU_ISSET_S(cpu, affinity_size, affinity))
+		{
+			continue;
+		}
+
+		ga_cpu_t info;
+		info._id = cpu;
+
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+		info._core = _ga_cpu_read_first(path);
+		info._core = info._core >= 0 ? info._core : cpu;
+
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+		info._package = _ga_cpu_read_int(path);
+
+		info._l3 = -1;
+		for (int index = 0; info._l3 < 0; ++index)
+		{
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+			int level = _ga_cpu_read_int(path);
+			if (level < 0)
+			{
+				break;
+			}
+			if (level == 3)
+			{
+				snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+				info._l3 = _ga_cpu_read_first(path);
+			}
+		}
+
+		_cpus.push_back(info);
+	}
+
+	CPU_FREE(affinity);
+
+	/* No sysfs; fall back to a flat topology. */
+	if (_cpus.empty())
+	{
+		int count = std::max(1, int(std::thread::hardware_concurrency()));
+		for (int cpu = 0; cpu < count; ++cpu)
+		{
+			_cpus.push_back({ cpu, cpu, 0, 0 });
+		}
+	}
+}
+
+bool ga_cpu_topology::pin_current_thread(int cpu)
+{
+	cpu_set_t* set = CPU_ALLOC(cpu + 1);
+	size_t set_size = CPU_ALLOC_SIZE(cpu + 1);
+	CPU_ZERO_S(set_size, set);
+	CPU_SET_S(cpu, set_size, set);
+	bool result = pthread_setaffinity_np(pthread_self(), set_size, set) == 0;
+	CPU_FREE(set);
+	return result;
+}
+
+#else
+
+ga_cpu_topology::ga_cpu_topology()
+{
+	int count = std::max(1, int(std::thread::hardware_concurrency()));
+	for (int cpu = 0; cpu < count; ++cpu)
+	{
+		_cpus.push_back({ cpu, cpu, 0, 0 });
+	}
+}
+
+bool ga_cpu_topology::pin_current_thread(int cpu)
+{
+#if defined(GA_MSVC) || defined(GA_MINGW)
+	/* Windows numbers CPUs within processor groups of 64. */
+	GROUP_AFFINITY affinity = {};
+	affinity.Group = WORD(cpu / 64);
+	affinity.Mask = KAFFINITY(1) << (cpu % 64);
+	return SetThreadGroupAffinity(GetCurrentThread(), &affinity, 0) != 0;
+#else
+	return false;
+#endif
+}
+
+#endif
+
+std::vector<int> ga_cpu_topology::get_physical_cores() const
+{
+	/* Siblings outside our affinity mask may own the core id, so dedupe. */
+	std::vector<int> cores;
+	std::vector<int> seen;
+	for (auto& cpu : _cpus)
+	{
+		if (std::find(seen.begin(), seen.end(), cpu._core) == seen.end())
+		{
+			seen.push_back(cpu._core);
+			cores.push_back(cpu._id);
+		}
+	}
+	return cores;
+}
+
+int ga_cpu_topology::get_l3(int cpu) const
+{
+	for (auto& info : _cpus)
+	{
+		if (info._id == cpu)
+		{
+			return info._l3;
+		}
+	}
+	return -1;
+}
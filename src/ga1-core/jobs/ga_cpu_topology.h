@@ -0,0 +1,49 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include <vector>
+
+/*
+** A logical CPU and where it sits in the cache hierarchy.
+** Core and L3 are identified by their lowest numbered logical CPU.
+*/
+struct ga_cpu_t
+{
+	int _id;
+	int _core;
+	int _package;
+	int _l3;
+};
+
+/*
+** Logical CPUs available to this process.
+** On Linux this is read from sysfs, restricted to the process affinity
+** mask. Elsewhere every CPU is reported as its own core sharing one L3.
+*/
+class ga_cpu_topology
+{
+public:
+	ga_cpu_topology();
+
+	const std::vector<ga_cpu_t>& get_cpus() const { return _cpus; }
+
+	/* The first logical CPU of each physical core. */
+	std::vector<int> get_physical_cores() const;
+
+	/* L3 cache of a logical CPU, or -1 if it isn't known. */
+	int get_l3(int cpu) const;
+
+	/* Pins the calling thread to one logical CPU. */
+	static bool pin_current_thread(int cpu);
+
+private:
+	std::vector<ga_cpu_t> _cpus;
+};
@@ -0,0 +1,135 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_deque.h"
+
+#include <atomic>
+#include <cstdint>
+
+static const int k_ga_deque_cache_line_size = 64;
+
+struct ga_deque_impl_t
+{
+	/* Stolen from by other threads. Kept on its own cache line. */
+	std::atomic<int64_t> _top;
+	char _top_pad[k_ga_deque_cache_line_size - sizeof(std::atomic<int64_t>)];
+
+	/* Only written by the owning thread. */
+	std::atomic<int64_t> _bottom;
+	char _bottom_pad[k_ga_deque_cache_line_size - sizeof(std::atomic<int64_t>)];
+
+	int64_t _mask;
+	std::atomic<void*>* _slots;
+};
+
+ga_deque::ga_deque(int capacity)
+{
+	/* Round capacity up to a power of two so indices can be masked. */
+	int64_t size = 1;
+	while (size < capacity)
+	{
+		size <<= 1;
+	}
+
+	auto impl = new ga_deque_impl_t;
+
+	impl->_top = 0;
+	impl->_bottom = 0;
+	impl->_mask = size - 1;
+	impl->_slots = new std::atomic<void*>[size];
+
+	_impl = impl;
+}
+
+ga_deque::~ga_deque()
+{
+	ga_deque_impl_t* impl = static_cast<ga_deque_impl_t*>(_impl);
+	delete[] impl->_slots;
+	delete impl;
+}
+
+bool ga_deque::push(void* data)
+{
+	ga_deque_impl_t* impl = static_cast<ga_deque_impl_t*>(_impl);
+
+	int64_t bottom = impl->_bottom.load(std::memory_order_relaxed);
+	int64_t top = impl->_top.load(std::memory_order_acquire);
+	if (bottom - top > impl->_mask)
+	{
+		return false;
+	}
+
+	impl->_slots[bottom & impl->_mask].store(data, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	impl->_bottom.store(bottom + 1, std::memory_order_relaxed);
+
+	return true;
+}
+
+bool ga_deque::pop(void** data)
+{
+	ga_deque_impl_t* impl = static_cast<ga_deque_impl_t*>(_impl);
+
+	/* Reserve the bottom element before looking at top. */
+	int64_t bottom = impl->_bottom.load(std::memory_order_relaxed) - 1;
+	impl->_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = impl->_top.load(std::memory_order_relaxed);
+
+	/* Deque was empty. Restore bottom. */
+	if (top > bottom)
+	{
+		impl->_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return false;
+	}
+
+	*data = impl->_slots[bottom & impl->_mask].load(std::memory_order_relaxed);
+
+	/* Last element. Race against thieves for it. */
+	bool result = true;
+	if (top == bottom)
+	{
+		result = impl->_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		impl->_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	return result;
+}
+
+bool ga_deque::steal(void** data)
+{
+	ga_deque_impl_t* impl = static_cast<ga_deque_impl_t*>(_impl);
+
+	int64_t top = impl->_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t bottom = impl->_bottom.load(std::memory_order_acquire);
+
+	if (top >= bottom)
+	{
+		return false;
+	}
+
+	/* Read before claiming; the owner can't overwrite until top moves. */
+	void* stolen = impl->_slots[top & impl->_mask].load(std::memory_order_relaxed);
+	if (!impl->_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		return false;
+	}
+
+	*data = stolen;
+	return true;
+}
+
+int ga_deque::get_count() const
+{
+	ga_deque_impl_t* impl = static_cast<ga_deque_impl_t*>(_impl);
+	int64_t bottom = impl->_bottom.load(std::memory_order_relaxed);
+	int64_t top = impl->_top.load(std::memory_order_relaxed);
+	return bottom > top ? int(bottom - top) : 0;
+}
@@ -0,0 +1,153 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+/*
+** Benchmark for worker parking.
+** Reports the latency of waking a parked thread, the latency of a job round
+** trip through an idle job system, and how much CPU idle workers burn.
+*/
+
+#include "ga_eventcount.h"
+#include "ga_job.h"
+
+#include "framework/ga_compiler_defines.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#if defined(GA_LINUX)
+#include <sys/resource.h>
+#else
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#undef WIN32_LEAN_AND_MEAN
+#endif
+
+typedef std::chrono::high_resolution_clock ga_bench_clock_t;
+
+static double get_process_cpu_ms()
+{
+#if defined(GA_LINUX)
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+		(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+#else
+	FILETIME creation, exit, kernel, user;
+	GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	return (k.QuadPart + u.QuadPart) / 10000.0;
+#endif
+}
+
+static void print_percentiles(const char* name, std::vector<double>& samples)
+{
+	std::sort(samples.begin(), samples.end());
+	size_t n = samples.size();
+	printf("%-24s p50 %8.2f us  p99 %8.2f us  max %8.2f us\n",
+		name, samples[n / 2], samples[n * 99 / 100], samples[n - 1]);
+}
+
+static void bench_wake_latency(int iterations)
+{
+	ga_eventcount eventcount;
+	std::atomic<int64_t> posted(0);
+	std::atomic<int> sequence(0);
+	std::vector<double> samples;
+	samples.reserve(iterations);
+
+	std::thread sleeper([&]()
+	{
+		for (int i = 1; i <= iterations; ++i)
+		{
+			for (;;)
+			{
+				uint32_t key = eventcount.prepare_wait();
+				if (sequence.load() >= i)
+				{
+					eventcount.cancel_wait();
+					break;
+				}
+				eventcount.commit_wait(key);
+			}
+			int64_t now = ga_bench_clock_t::now().time_since_epoch().count();
+			samples.push_back(std::chrono::duration<double, std::micro>(ga_bench_clock_t::duration(now - posted.load())).count());
+		}
+	});
+
+	for (int i = 1; i <= iterations; ++i)
+	{
+		// Give the sleeper time to actually park.
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+		posted = ga_bench_clock_t::now().time_since_epoch().count();
+		sequence = i;
+		eventcount.notify(1);
+	}
+	sleeper.join();
+
+	print_percentiles("eventcount wake", samples);
+}
+
+static void bench_job_round_trip(int iterations)
+{
+	std::vector<double> samples;
+	samples.reserve(iterations);
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		// Let the workers go back to sleep between jobs.
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+		ga_job_decl_t decl;
+		decl._entry = [](void* data) {};
+		decl._data = 0;
+
+		auto t0 = ga_bench_clock_t::now();
+		ga_job_counter counter;
+		ga_job::run(&decl, 1, &counter);
+		ga_job::wait(&counter);
+		auto t1 = ga_bench_clock_t::now();
+
+		samples.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+	}
+
+	print_percentiles("idle job round trip", samples);
+}
+
+static void bench_idle_cpu(int ms)
+{
+	double cpu0 = get_process_cpu_ms();
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+	double cpu1 = get_process_cpu_ms();
+
+	printf("%-24s %.2f ms CPU over %d ms idle (%u hardware threads)\n",
+		"idle job system", cpu1 - cpu0, ms, std::thread::hardware_concurrency());
+}
+
+int main(int argc, const char** argv)
+{
+	bench_wake_latency(2000);
+
+	ga_job::startup(0xffffffff, 256, 256);
+
+	bench_job_round_trip(2000);
+	bench_idle_cpu(2000);
+
+	ga_job::shutdown();
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_eventcount.h"
+
+#include <climits>
+
+#if defined(GA_LINUX)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static void _ga_futex_wait(std::atomic<uint32_t>* address, uint32_t expected)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAIT_PRIVATE, expected, 0, 0, 0);
+}
+
+static void _ga_futex_wake(std::atomic<uint32_t>* address, int count)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAKE_PRIVATE, count, 0, 0, 0);
+}
+#endif
+
+ga_eventcount::ga_eventcount() : _epoch(0), _waiters(0)
+{
+}
+
+ga_eventcount::~ga_eventcount()
+{
+}
+
+uint32_t ga_eventcount::prepare_wait()
+{
+	/*
+	** Registering before reading the epoch pairs with the fence in notify():
+	** either the notifier sees us, or we see whatever it published.
+	*/
+	_waiters.fetch_add(1, std::memory_order_seq_cst);
+	return _epoch.load(std::memory_order_seq_cst);
+}
+
+void ga_eventcount::cancel_wait()
+{
+	_waiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void ga_eventcount::commit_wait(uint32_t key)
+{
+#if defined(GA_LINUX)
+	while (_epoch.load(std::memory_order_acquire) == key)
+	{
+		_ga_futex_wait(&_epoch, key);
+	}
+#else
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (_epoch.load(std::memory_order_acquire) == key)
+		{
+			_condvar.wait(lock);
+		}
+	}
+#endif
+	_waiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+int ga_eventcount::notify(int count)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int waiters = _waiters.load(std::memory_order_relaxed);
+	if (waiters <= 0 || count <= 0)
+	{
+		return 0;
+	}
+
+	int wake_count = count < waiters ? count : waiters;
+
+#if defined(GA_LINUX)
+	_epoch.fetch_add(1, std::memory_order_seq_cst);
+	_ga_futex_wake(&_epoch, wake_count);
+#else
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_epoch.fetch_add(1, std::memory_order_seq_cst);
+	}
+	if (wake_count == waiters)
+	{
+		_condvar.notify_all();
+	}
+	else
+	{
+		for (int i = 0; i < wake_count; ++i)
+		{
+			_condvar.notify_one();
+		}
+	}
+#endif
+
+	return wake_count;
+}
+
+void ga_eventcount::notify_all()
+{
+	notify(INT_MAX);
+}
+
+int ga_eventcount::get_waiter_count() const
+{
+	return _waiters.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "framework/ga_compiler_defines.h"
+
+#include <atomic>
+#include <cstdint>
+
+#if !defined(GA_LINUX)
+#include <condition_variable>
+#include <mutex>
+#endif
+
+/*
+** Event count: lets threads park until some condition they poll for may
+** have become true, without lost wakeups and without waking everyone.
+**
+** Waiter:
+**   key = prepare_wait();
+**   if (condition) { cancel_wait(); } else { commit_wait(key); }
+** Notifier:
+**   make condition true; notify(n);
+**
+** notify() is a couple of atomic operations when nobody is parked.
+** On Linux parked threads sleep on a futex; elsewhere on a condvar.
+*/
+class ga_eventcount
+{
+public:
+	ga_eventcount();
+	~ga_eventcount();
+
+	uint32_t prepare_wait();
+	void cancel_wait();
+	void commit_wait(uint32_t key);
+
+	/* Wakes up to count waiters. Returns how many waiters were signaled. */
+	int notify(int count);
+	void notify_all();
+
+	int get_waiter_count() const;
+
+private:
+	std::atomic<uint32_t> _epoch;
+	std::atomic<int32_t> _waiters;
+
+#if !defined(GA_LINUX)
+	std::condition_variable _condvar;
+	std::mutex _mutex;
+#endif
+};
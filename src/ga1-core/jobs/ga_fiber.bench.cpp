@@ -0,0 +1,80 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+/*
+** Microbenchmark for ga_fiber::switch_to.
+** Reports the cost of a round trip: thread fiber -> worker fiber -> thread fiber.
+*/
+
+#include "ga_fiber.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+struct ga_fiber_bench_t
+{
+	ga_fiber _thread_fiber;
+	ga_fiber _worker_fiber;
+	uint64_t _switch_count;
+};
+
+static void ga_fiber_bench_worker(void* data)
+{
+	for (;;)
+	{
+		ga_fiber_bench_t* bench = static_cast<ga_fiber_bench_t*>(ga_fiber::get_data());
+		bench->_switch_count++;
+		ga_fiber::switch_to(bench->_thread_fiber);
+	}
+}
+
+int main(int argc, const char** argv)
+{
+	const int k_round_trips = argc > 1 ? atoi(argv[1]) : 10000000;
+	const int k_runs = 5;
+
+	ga_fiber_bench_t bench;
+	bench._switch_count = 0;
+	bench._thread_fiber = ga_fiber::convert_thread(&bench);
+	bench._worker_fiber = ga_fiber(ga_fiber_bench_worker, &bench, 64 * 1024);
+
+	// Warm up the stack and caches.
+	for (int i = 0; i < 1000; ++i)
+	{
+		ga_fiber::switch_to(bench._worker_fiber);
+	}
+
+	double best_ns = 1e30;
+	for (int run = 0; run < k_runs; ++run)
+	{
+		auto t0 = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < k_round_trips; ++i)
+		{
+			ga_fiber::switch_to(bench._worker_fiber);
+		}
+		auto t1 = std::chrono::high_resolution_clock::now();
+
+		double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / k_round_trips;
+		best_ns = ns < best_ns ? ns : best_ns;
+		printf("run %d: %.2f ns per switch_to round trip (%.2f ns per switch)\n", run, ns, ns * 0.5);
+	}
+
+	if (bench._switch_count != uint64_t(k_round_trips) * k_runs + 1000)
+	{
+		printf("error: expected %llu switches, counted %llu\n",
+			(unsigned long long)(uint64_t(k_round_trips) * k_runs + 1000),
+			(unsigned long long)bench._switch_count);
+		return 1;
+	}
+
+	printf("best: %.2f ns per switch_to round trip\n", best_ns);
+	return 0;
+}
@@ -9,6 +9,8 @@
 
 #include "ga_fiber.h"
 
+#if defined(GA_MSVC) || defined(GA_MINGW)
+
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #undef WIN32_LEAN_AND_MEAN
@@ -19,7 +21,9 @@ ga_fiber::ga_fiber(function_t func, void* func_data, size_t stack_size)
 	stack_size = stack_size > k_stack_align ? stack_size : k_stack_align;
 	stack_size = (stack_size + k_stack_align - 1) & ~(k_stack_align - 1);
 
-	_impl = CreateFiber(stack_size, (LPFIBER_START_ROUTINE)func, func_data);
+	/* Windows commits fiber stacks on demand behind its own guard page. */
+	const size_t k_stack_commit = 4 * 1024;
+	_impl = CreateFiberEx(k_stack_commit, stack_size, 0, (LPFIBER_START_ROUTINE)func, func_data);
 }
 
 ga_fiber::~ga_fiber()
@@ -30,29 +34,214 @@ ga_fiber::~ga_fiber()
 	}
 }
 
-ga_fiber& ga_fiber::operator=(ga_fiber&& other)
+ga_fiber ga_fiber::convert_thread(void* data)
 {
-	if (&other != this)
+	ga_fiber fiber;
+	fiber._impl = ConvertThreadToFiber(data);
+	return fiber;
+}
+
+void ga_fiber::revert_thread()
+{
+	ConvertFiberToThread();
+	_impl = 0;
+}
+
+void ga_fiber::switch_to(const ga_fiber& fiber)
+{
+	SwitchToFiber(fiber._impl);
+}
+
+void* ga_fiber::get_data()
+{
+	return IsThreadAFiber() ? GetFiberData() : 0;
+}
+
+#elif defined(GA_LINUX) && defined(__x86_64__)
+
+#include <cassert>
+#include <cstdint>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+** Linux fibers use a hand-written context switch rather than ucontext.
+** swapcontext saves and restores the signal mask with a syscall on every
+** switch; job fibers never touch the signal mask, so we only save the
+** callee-saved registers required by the System V x86-64 ABI.
+*/
+struct ga_fiber_impl_t
+{
+	/* Saved stack pointer while the fiber is switched out. */
+	void* _stack_pointer;
+
+	void* _data;
+
+	/* Stack mapping, guard page included; null for threads converted to fibers. */
+	void* _stack;
+	size_t _stack_size;
+};
+
+extern "C" void _ga_fiber_switch_context(void** from_stack_pointer, void* to_stack_pointer);
+extern "C" void _ga_fiber_entry();
+
+/*
+** Saves rbp, rbx and r12-r15 plus the SSE and x87 control words on the
+** current stack, swaps stacks, then restores the same from the new stack.
+** New fibers begin in _ga_fiber_entry with the function in r12 and its data
+** in r13.
+*/
+asm(
+	".text\n"
+	".globl _ga_fiber_switch_context\n"
+	".type _ga_fiber_switch_context,@function\n"
+	".p2align 4\n"
+	"_ga_fiber_switch_context:\n"
+	"	pushq %rbp\n"
+	"	pushq %rbx\n"
+	"	pushq %r12\n"
+	"	pushq %r13\n"
+	"	pushq %r14\n"
+	"	pushq %r15\n"
+	"	subq $8, %rsp\n"
+	"	stmxcsr (%rsp)\n"
+	"	fnstcw 4(%rsp)\n"
+	"	movq %rsp, (%rdi)\n"
+	"	movq %rsi, %rsp\n"
+	"	ldmxcsr (%rsp)\n"
+	"	fldcw 4(%rsp)\n"
+	"	addq $8, %rsp\n"
+	"	popq %r15\n"
+	"	popq %r14\n"
+	"	popq %r13\n"
+	"	popq %r12\n"
+	"	popq %rbx\n"
+	"	popq %rbp\n"
+	"	ret\n"
+	".size _ga_fiber_switch_context,.-_ga_fiber_switch_context\n"
+	".globl _ga_fiber_entry\n"
+	".type _ga_fiber_entry,@function\n"
+	".p2align 4\n"
+	"_ga_fiber_entry:\n"
+	"	movq %r13, %rdi\n"
+	"	callq *%r12\n"
+	"	ud2\n"
+	".size _ga_fiber_entry,.-_ga_fiber_entry\n"
+);
+
+static thread_local ga_fiber_impl_t* _ga_fiber_current = 0;
+
+ga_fiber::ga_fiber(function_t func, void* func_data, size_t stack_size)
+{
+	const size_t k_stack_align = 64 * 1024;
+	stack_size = stack_size > k_stack_align ? stack_size : k_stack_align;
+	stack_size = (stack_size + k_stack_align - 1) & ~(k_stack_align - 1);
+
+	/*
+	** Reserve without committing; pages are backed as the stack grows into
+	** them. The lowest page is left inaccessible to catch overflow.
+	*/
+	size_t guard_size = size_t(sysconf(_SC_PAGESIZE));
+
+	ga_fiber_impl_t* impl = new ga_fiber_impl_t;
+	impl->_data = func_data;
+	impl->_stack_size = stack_size + guard_size;
+	impl->_stack = mmap(0, impl->_stack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_NORESERVE, -1, 0);
+	assert(impl->_stack != MAP_FAILED);
+	mprotect(impl->_stack, guard_size, PROT_NONE);
+
+	/*
+	** Build the initial frame _ga_fiber_switch_context will pop. The return
+	** address slot is placed so the stack is 16-byte aligned at the call in
+	** _ga_fiber_entry, as the ABI requires.
+	*/
+	uint64_t* top = reinterpret_cast<uint64_t*>(static_cast<char*>(impl->_stack) + impl->_stack_size);
+	top[-1] = 0;
+	top[-2] = 0;
+	top[-3] = reinterpret_cast<uint64_t>(&_ga_fiber_entry);
+	top[-4] = 0;                                      /* rbp */
+	top[-5] = 0;                                      /* rbx */
+	top[-6] = reinterpret_cast<uint64_t>(func);       /* r12 */
+	top[-7] = reinterpret_cast<uint64_t>(func_data);  /* r13 */
+	top[-8] = 0;                                      /* r14 */
+	top[-9] = 0;                                      /* r15 */
+	top[-10] = 0x1f80 | (uint64_t(0x037f) << 32);     /* mxcsr, x87 control word */
+	impl->_stack_pointer = top - 10;
+
+	_impl = impl;
+}
+
+ga_fiber::~ga_fiber()
+{
+	if (_impl)
 	{
-		_impl = other._impl;
-		other._impl = 0;
+		ga_fiber_impl_t* impl = static_cast<ga_fiber_impl_t*>(_impl);
+		if (impl->_stack)
+		{
+			munmap(impl->_stack, impl->_stack_size);
+		}
+		if (_ga_fiber_current == impl)
+		{
+			_ga_fiber_current = 0;
+		}
+		delete impl;
 	}
-	return *this;
 }
 
 ga_fiber ga_fiber::convert_thread(void* data)
 {
+	ga_fiber_impl_t* impl = new ga_fiber_impl_t;
+	impl->_stack_pointer = 0;
+	impl->_data = data;
+	impl->_stack = 0;
+	impl->_stack_size = 0;
+
+	_ga_fiber_current = impl;
+
 	ga_fiber fiber;
-	fiber._impl = ConvertThreadToFiber(data);
+	fiber._impl = impl;
 	return fiber;
 }
 
-void ga_fiber::switch_to(const ga_fiber& fiber)
+void ga_fiber::revert_thread()
 {
-	SwitchToFiber(fiber._impl);
+	ga_fiber_impl_t* impl = static_cast<ga_fiber_impl_t*>(_impl);
+	if (_ga_fiber_current == impl)
+	{
+		_ga_fiber_current = 0;
+	}
+	delete impl;
+	_impl = 0;
 }
 
-void* ga_fiber::get_data()
+__attribute__((noinline)) void ga_fiber::switch_to(const ga_fiber& fiber)
+{
+	ga_fiber_impl_t* from = _ga_fiber_current;
+	ga_fiber_impl_t* to = static_cast<ga_fiber_impl_t*>(fiber._impl);
+
+	/*
+	** Fibers may resume on a different thread than the one they were
+	** suspended on, so the current fiber must not be read after the switch.
+	*/
+	_ga_fiber_current = to;
+	_ga_fiber_switch_context(&from->_stack_pointer, to->_stack_pointer);
+}
+
+__attribute__((noinline)) void* ga_fiber::get_data()
+{
+	return _ga_fiber_current ? _ga_fiber_current->_data : 0;
+}
+
+#else
+#error "ga_fiber is not implemented for this platform."
+#endif
+
+ga_fiber& ga_fiber::operator=(ga_fiber&& other)
 {
-	return GetFiberData();
+	if (&other != this)
+	{
+		_impl = other._impl;
+		other._impl = 0;
+	}
+	return *this;
 }
@@ -11,13 +11,14 @@
 
 #include "framework/ga_compiler_defines.h"
 
-#if defined(GA_MINGW)
-#include <sys/types.h>
-#endif
+#include <cstddef>
 
 /*
 ** A fiber object.
 ** This the execution context for a thread including the registers and stack.
+**
+** Stacks are reserved up front but only committed as they're touched, and
+** sit above a guard page so an overflow faults instead of corrupting memory.
 */
 class ga_fiber
 {
@@ -31,8 +32,13 @@ public:
 
 	ga_fiber& operator=(ga_fiber&& other);
 
+	bool is_valid() const { return _impl != 0; }
+
 	static ga_fiber convert_thread(void* data);
+	void revert_thread();
 	static void switch_to(const ga_fiber& fiber);
+
+	/* Returns 0 on threads that were never converted to fibers. */
 	static void* get_data();
 
 private:
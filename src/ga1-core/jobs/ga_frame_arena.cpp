@@ -0,0 +1,151 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_frame_arena.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+struct ga_frame_arena_block_t
+{
+	char* _data;
+	size_t _size;
+
+	/* Can run past _size when racing allocations overflow the block. */
+	std::atomic<size_t> _offset;
+
+	ga_frame_arena_block_t* _next;
+};
+
+struct ga_frame_arena_impl_t
+{
+	size_t _block_size;
+
+	ga_frame_arena_block_t* _first;
+	std::atomic<ga_frame_arena_block_t*> _current;
+
+	/* Held only to move on to the next block. */
+	std::mutex _grow_mutex;
+	std::atomic<int> _block_count;
+};
+
+static ga_frame_arena_block_t* _ga_frame_arena_new_block(ga_frame_arena_impl_t* impl, size_t size);
+
+ga_frame_arena::ga_frame_arena(size_t block_size)
+{
+	auto impl = new ga_frame_arena_impl_t;
+
+	impl->_block_size = block_size;
+	impl->_block_count = 0;
+	impl->_first = _ga_frame_arena_new_block(impl, block_size);
+	impl->_current = impl->_first;
+
+	_impl = impl;
+}
+
+ga_frame_arena::~ga_frame_arena()
+{
+	ga_frame_arena_impl_t* impl = static_cast<ga_frame_arena_impl_t*>(_impl);
+
+	ga_frame_arena_block_t* block = impl->_first;
+	while (block)
+	{
+		ga_frame_arena_block_t* next = block->_next;
+		delete[] block->_data;
+		delete block;
+		block = next;
+	}
+
+	delete impl;
+}
+
+void* ga_frame_arena::alloc(size_t size, size_t alignment)
+{
+	ga_frame_arena_impl_t* impl = static_cast<ga_frame_arena_impl_t*>(_impl);
+
+	/* Reserve enough to align the start wherever the offset lands. */
+	size_t reserve = size + alignment - 1;
+
+	for (;;)
+	{
+		ga_frame_arena_block_t* block = impl->_current.load(std::memory_order_acquire);
+
+		size_t offset = block->_offset.fetch_add(reserve, std::memory_order_relaxed);
+		if (offset + reserve <= block->_size)
+		{
+			uintptr_t p = reinterpret_cast<uintptr_t>(block->_data + offset);
+			p = (p + alignment - 1) & ~uintptr_t(alignment - 1);
+			return reinterpret_cast<void*>(p);
+		}
+
+		/*
+		** Out of room. Move on to the next block, reusing one from an earlier
+		** frame if it's big enough. Whoever loses the race just retries.
+		*/
+		std::lock_guard<std::mutex> lock(impl->_grow_mutex);
+		if (impl->_current.load(std::memory_order_relaxed) == block)
+		{
+			ga_frame_arena_block_t* next = block->_next;
+			if (!next || next->_size < reserve)
+			{
+				next = _ga_frame_arena_new_block(impl, reserve > impl->_block_size ? reserve : impl->_block_size);
+				next->_next = block->_next;
+				block->_next = next;
+			}
+			impl->_current.store(next, std::memory_order_release);
+		}
+	}
+}
+
+void ga_frame_arena::reset()
+{
+	ga_frame_arena_impl_t* impl = static_cast<ga_frame_arena_impl_t*>(_impl);
+
+	for (ga_frame_arena_block_t* block = impl->_first; block; block = block->_next)
+	{
+		block->_offset.store(0, std::memory_order_relaxed);
+	}
+	impl->_current.store(impl->_first, std::memory_order_release);
+}
+
+size_t ga_frame_arena::get_used() const
+{
+	ga_frame_arena_impl_t* impl = static_cast<ga_frame_arena_impl_t*>(_impl);
+
+	size_t used = 0;
+	ga_frame_arena_block_t* current = impl->_current.load(std::memory_order_acquire);
+	for (ga_frame_arena_block_t* block = impl->_first; block; block = block->_next)
+	{
+		size_t offset = block->_offset.load(std::memory_order_relaxed);
+		used += offset < block->_size ? offset : block->_size;
+		if (block == current)
+		{
+			break;
+		}
+	}
+	return used;
+}
+
+int ga_frame_arena::get_block_count() const
+{
+	ga_frame_arena_impl_t* impl = static_cast<ga_frame_arena_impl_t*>(_impl);
+	return impl->_block_count.load(std::memory_order_relaxed);
+}
+
+static ga_frame_arena_block_t* _ga_frame_arena_new_block(ga_frame_arena_impl_t* impl, size_t size)
+{
+	ga_frame_arena_block_t* block = new ga_frame_arena_block_t;
+	block->_data = new char[size];
+	block->_size = size;
+	block->_offset = 0;
+	block->_next = 0;
+	impl->_block_count++;
+	return block;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+** Thread-safe linear allocator for memory that lives until reset().
+** Allocating bumps an atomic offset into the current block. Nothing is
+** freed on its own; reset() rewinds every block at once.
+**
+** Blocks are kept across resets, so once the arena has grown to fit a
+** frame, later frames don't touch the heap.
+*/
+class ga_frame_arena
+{
+public:
+	ga_frame_arena(size_t block_size = 1 << 20);
+	~ga_frame_arena();
+
+	void* alloc(size_t size, size_t alignment);
+
+	/* Not thread-safe. Nobody may be allocating or using the memory. */
+	void reset();
+
+	/* Bytes handed out since the last reset, and blocks taken from the heap. */
+	size_t get_used() const;
+	int get_block_count() const;
+
+private:
+	void* _impl;
+};
+
+/*
+** STL allocator over a ga_frame_arena. Deallocation does nothing, so a
+** container using it must not outlive the arena's next reset.
+*/
+template<class T>
+struct ga_frame_allocator
+{
+	typedef T value_type;
+
+	ga_frame_allocator(ga_frame_arena* arena) : _arena(arena) {}
+
+	template<class U>
+	ga_frame_allocator(const ga_frame_allocator<U>& other) : _arena(other._arena) {}
+
+	T* allocate(size_t count)
+	{
+		return static_cast<T*>(_arena->alloc(count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, size_t) {}
+
+	ga_frame_arena* _arena;
+};
+
+template<class T, class U>
+inline bool operator==(const ga_frame_allocator<T>& a, const ga_frame_allocator<U>& b)
+{
+	return a._arena == b._arena;
+}
+
+template<class T, class U>
+inline bool operator!=(const ga_frame_allocator<T>& a, const ga_frame_allocator<U>& b)
+{
+	return a._arena != b._arena;
+}
+
+/* A vector whose storage lives in a ga_frame_arena. */
+template<class T>
+using ga_frame_vector = std::vector<T, ga_frame_allocator<T>>;
@@ -26,7 +26,8 @@ union ga_intpool_pointer_t
 	ga_intpool_nodecount_t _part;
 
 	ga_intpool_pointer_t() {}
-	ga_intpool_pointer_t(const ga_intpool_pointer_t& other) : _entire(other._entire) {}
+	/* Copies must be real loads, or the compiler may fold away the consistency re-checks. */
+	ga_intpool_pointer_t(const ga_intpool_pointer_t& other) : _entire(other._atomic.load(std::memory_order_acquire)) {}
 };
 
 struct ga_intpool_node_t
@@ -80,18 +81,21 @@ int ga_intpool::alloc()
 	{
 		ga_intpool_pointer_t free_list = impl->_free_list;
 
-		if (free_list._part._index != k_ga_intpool_invalid_index)
+		/* Exhausted. Let the caller decide how to back off. */
+		if (free_list._part._index == k_ga_intpool_invalid_index)
 		{
-			index = free_list._part._index;
-			ga_intpool_pointer_t next = impl->_nodes[index]._next;
-
-			ga_intpool_pointer_t link;
-			link._part._index = next._part._index;
-			link._part._count = free_list._part._count + 1;
-			if (impl->_free_list._atomic.compare_exchange_strong(free_list._entire, link._entire))
-			{
-				break;
-			}
+			return -1;
+		}
+
+		index = free_list._part._index;
+		ga_intpool_pointer_t next = impl->_nodes[index]._next;
+
+		ga_intpool_pointer_t link;
+		link._part._index = next._part._index;
+		link._part._count = free_list._part._count + 1;
+		if (impl->_free_list._atomic.compare_exchange_strong(free_list._entire, link._entire))
+		{
+			break;
 		}
 	}
 
@@ -18,6 +18,7 @@ public:
 	ga_intpool(int index_count);
 	~ga_intpool();
 
+	/* Returns -1 when every index is in use. */
 	int alloc();
 	void free(int index);
 
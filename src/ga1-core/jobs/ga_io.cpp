@@ -0,0 +1,695 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_io.h"
+
+#include "ga_fiber.h"
+#include "ga_job.h"
+
+#include "framework/ga_compiler_defines.h"
+
+#include <algorithm>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#if defined(GA_MSVC) || defined(GA_MINGW)
+#include <io.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+#if defined(GA_LINUX) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define GA_IO_URING
+#endif
+#endif
+#endif
+
+void* ga_io::_impl = 0;
+
+struct ga_io_request_t
+{
+	const char* _path;
+	uint64_t _offset;
+	char* _buffer;
+	size_t _size;
+
+	/* Whole-file reads size this to the file once it's open. */
+	std::string* _contents;
+
+	int _fd;
+	size_t _done;
+	int64_t _result;
+
+#if defined(GA_IO_URING)
+	struct iovec _iov;
+#endif
+
+	/* Held open while the read is in flight. */
+	ga_job_counter _counter;
+	ga_io_request_t* _next;
+};
+
+#if defined(GA_IO_URING)
+struct ga_io_uring_t
+{
+	int _fd;
+	unsigned _entries;
+
+	unsigned* _sq_head;
+	unsigned* _sq_tail;
+	unsigned* _sq_mask;
+	unsigned* _sq_array;
+	io_uring_sqe* _sqes;
+	unsigned _to_submit;
+
+	unsigned* _cq_head;
+	unsigned* _cq_tail;
+	unsigned* _cq_mask;
+	io_uring_cqe* _cqes;
+
+	void* _sq_ring;
+	size_t _sq_ring_size;
+	void* _cq_ring;
+	size_t _cq_ring_size;
+	size_t _sqes_size;
+};
+
+static const unsigned k_ga_io_uring_entries = 256;
+#endif
+
+struct ga_io_impl_t
+{
+	std::thread::id _main_thread;
+
+	/* Requests not yet picked up by an I/O thread, oldest first. */
+	std::mutex _mutex;
+	std::condition_variable _condvar;
+	ga_io_request_t* _head;
+	ga_io_request_t* _tail;
+	bool _terminate;
+
+	std::vector<std::thread*> _threads;
+
+#if defined(GA_IO_URING)
+	/* Null when the kernel won't give us a ring; the pool is used instead. */
+	ga_io_uring_t* _uring;
+	int _event_fd;
+
+	/* The ring broke. Its thread serves the queue as a pool thread now. */
+	bool _uring_failed;
+#endif
+};
+
+static int64_t _ga_io_submit(ga_io_impl_t* impl, ga_io_request_t* request);
+static bool _ga_io_open(ga_io_request_t* request);
+static void _ga_io_execute(ga_io_request_t* request);
+static void _ga_io_read_rest(ga_io_request_t* request);
+static void _ga_io_finish(ga_io_request_t* request, int64_t result);
+static int64_t _ga_io_pread(int fd, void* buffer, size_t size, uint64_t offset);
+static void _ga_io_pool_thread(ga_io_impl_t* impl);
+
+#if defined(GA_IO_URING)
+static ga_io_uring_t* _ga_io_uring_create(unsigned entries);
+static void _ga_io_uring_destroy(ga_io_uring_t* uring);
+static io_uring_sqe* _ga_io_uring_get_sqe(ga_io_uring_t* uring);
+static void _ga_io_uring_push_sqe(ga_io_uring_t* uring);
+static void _ga_io_uring_thread(ga_io_impl_t* impl);
+#endif
+
+void ga_io::startup(int thread_count)
+{
+	ga_io_impl_t* impl = new ga_io_impl_t;
+	impl->_main_thread = std::this_thread::get_id();
+	impl->_head = 0;
+	impl->_tail = 0;
+	impl->_terminate = false;
+
+#if defined(GA_IO_URING)
+	impl->_uring = _ga_io_uring_create(k_ga_io_uring_entries);
+	impl->_uring_failed = false;
+	impl->_event_fd = impl->_uring ? eventfd(0, EFD_CLOEXEC) : -1;
+	if (impl->_uring && impl->_event_fd >= 0)
+	{
+		impl->_threads.push_back(new std::thread(_ga_io_uring_thread, impl));
+		_impl = impl;
+		return;
+	}
+
+	if (impl->_uring)
+	{
+		_ga_io_uring_destroy(impl->_uring);
+		impl->_uring = 0;
+	}
+#endif
+
+	for (int i = 0; i < thread_count; ++i)
+	{
+		impl->_threads.push_back(new std::thread(_ga_io_pool_thread, impl));
+	}
+	_impl = impl;
+}
+
+void ga_io::shutdown()
+{
+	ga_io_impl_t* impl = static_cast<ga_io_impl_t*>(_impl);
+
+	{
+		std::lock_guard<std::mutex> lock(impl->_mutex);
+		impl->_terminate = true;
+	}
+	impl->_condvar.notify_all();
+
+#if defined(GA_IO_URING)
+	if (impl->_uring)
+	{
+		uint64_t one = 1;
+		ssize_t written = write(impl->_event_fd, &one, sizeof(one));
+		(void)written;
+	}
+#endif
+
+	for (auto& t : impl->_threads)
+	{
+		t->join();
+		delete t;
+	}
+
+#if defined(GA_IO_URING)
+	if (impl->_uring)
+	{
+		_ga_io_uring_destroy(impl->_uring);
+		close(impl->_event_fd);
+	}
+#endif
+
+	_impl = 0;
+	delete impl;
+}
+
+bool ga_io::read_file(const char* path, std::string& contents)
+{
+	ga_io_request_t request;
+	request._path = path;
+	request._offset = 0;
+	request._buffer = 0;
+	request._size = 0;
+	request._contents = &contents;
+
+	return _ga_io_submit(static_cast<ga_io_impl_t*>(_impl), &request) >= 0;
+}
+
+int64_t ga_io::read(const char* path, uint64_t offset, void* buffer, size_t size)
+{
+	ga_io_request_t request;
+	request._path = path;
+	request._offset = offset;
+	request._buffer = static_cast<char*>(buffer);
+	request._size = size;
+	request._contents = 0;
+
+	return _ga_io_submit(static_cast<ga_io_impl_t*>(_impl), &request);
+}
+
+static int64_t _ga_io_submit(ga_io_impl_t* impl, ga_io_request_t* request)
+{
+	request->_fd = -1;
+	request->_done = 0;
+	request->_result = -1;
+	request->_next = 0;
+
+	/*
+	** Only jobs and the main thread can wait on a counter. Anyone else, or
+	** anyone before startup, just reads.
+	*/
+	bool can_wait = impl &&
+		(ga_fiber::get_data() != 0 || std::this_thread::get_id() == impl->_main_thread);
+	if (!can_wait)
+	{
+		_ga_io_execute(request);
+		return request->_result;
+	}
+
+	ga_job::add_external(&request->_counter, 1);
+
+#if defined(GA_IO_URING)
+	bool use_ring = false;
+#endif
+	{
+		std::lock_guard<std::mutex> lock(impl->_mutex);
+#if defined(GA_IO_URING)
+		use_ring = impl->_uring && !impl->_uring_failed;
+#endif
+		if (impl->_tail)
+		{
+			impl->_tail->_next = request;
+		}
+		else
+		{
+			impl->_head = request;
+		}
+		impl->_tail = request;
+	}
+
+#if defined(GA_IO_URING)
+	if (use_ring)
+	{
+		uint64_t one = 1;
+		ssize_t written = write(impl->_event_fd, &one, sizeof(one));
+		(void)written;
+	}
+	else
+#endif
+	{
+		impl->_condvar.notify_one();
+	}
+
+	ga_job::wait(&request->_counter);
+	return request->_result;
+}
+
+static bool _ga_io_open(ga_io_request_t* request)
+{
+#if defined(GA_MSVC) || defined(GA_MINGW)
+	request->_fd = _open(request->_path, _O_RDONLY | _O_BINARY);
+#else
+	request->_fd = open(request->_path, O_RDONLY | O_CLOEXEC);
+#endif
+	if (request->_fd < 0)
+	{
+		return false;
+	}
+
+	if (request->_contents)
+	{
+#if defined(GA_MSVC) || defined(GA_MINGW)
+		struct _stat64 st;
+		if (_fstat64(request->_fd, &st) != 0)
+#else
+		struct stat st;
+		if (fstat(request->_fd, &st) != 0)
+#endif
+		{
+			return false;
+		}
+
+		request->_contents->resize(size_t(st.st_size));
+		request->_buffer = request->_contents->empty() ? 0 : &(*request->_contents)[0];
+		request->_size = request->_contents->size();
+	}
+	return true;
+}
+
+/* Blocking read on the calling thread, for the pool and the fallback. */
+static void _ga_io_execute(ga_io_request_t* request)
+{
+	if (!_ga_io_open(request))
+	{
+		_ga_io_finish(request, -1);
+		return;
+	}
+	_ga_io_read_rest(request);
+}
+
+/* Blocking read of whatever an open request hasn't read yet. */
+static void _ga_io_read_rest(ga_io_request_t* request)
+{
+	while (request->_done < request->_size)
+	{
+		int64_t count = _ga_io_pread(request->_fd, request->_buffer + request->_done,
+			request->_size - request->_done, request->_offset + request->_done);
+		if (count < 0)
+		{
+			_ga_io_finish(request, -1);
+			return;
+		}
+		if (count == 0)
+		{
+			break;
+		}
+		request->_done += size_t(count);
+	}
+	_ga_io_finish(request, int64_t(request->_done));
+}
+
+static void _ga_io_finish(ga_io_request_t* request, int64_t result)
+{
+	if (request->_fd >= 0)
+	{
+#if defined(GA_MSVC) || defined(GA_MINGW)
+		_close(request->_fd);
+#else
+		close(request->_fd);
+#endif
+		request->_fd = -1;
+	}
+
+	/* A whole file that came up short is a failure, not a partial read. */
+	if (request->_contents && result >= 0 && size_t(result) != request->_contents->size())
+	{
+		result = -1;
+	}
+	request->_result = result;
+}
+
+static int64_t _ga_io_pread(int fd, void* buffer, size_t size, uint64_t offset)
+{
+#if defined(GA_MSVC) || defined(GA_MINGW)
+	/* Every request opens its own descriptor, so seeking is safe. */
+	if (_lseeki64(fd, int64_t(offset), SEEK_SET) < 0)
+	{
+		return -1;
+	}
+	return _read(fd, buffer, unsigned(size < INT_MAX ? size : INT_MAX));
+#else
+	for (;;)
+	{
+		ssize_t count = pread(fd, buffer, size, off_t(offset));
+		if (count >= 0 || errno != EINTR)
+		{
+			return count;
+		}
+	}
+#endif
+}
+
+static void _ga_io_pool_thread(ga_io_impl_t* impl)
+{
+	for (;;)
+	{
+		ga_io_request_t* request;
+		{
+			std::unique_lock<std::mutex> lock(impl->_mutex);
+			impl->_condvar.wait(lock, [impl]() { return impl->_head || impl->_terminate; });
+			if (!impl->_head)
+			{
+				return;
+			}
+
+			request = impl->_head;
+			impl->_head = request->_next;
+			if (!impl->_head)
+			{
+				impl->_tail = 0;
+			}
+		}
+
+		_ga_io_execute(request);
+
+		/* The requester may resume and free the request from here on. */
+		ga_job::complete_external(&request->_counter);
+	}
+}
+
+#if defined(GA_IO_URING)
+
+static ga_io_uring_t* _ga_io_uring_create(unsigned entries)
+{
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	/* Fails on old kernels and where seccomp forbids it. */
+	int fd = int(syscall(__NR_io_uring_setup, entries, &params));
+	if (fd < 0)
+	{
+		return 0;
+	}
+
+	ga_io_uring_t* uring = new ga_io_uring_t;
+	memset(uring, 0, sizeof(*uring));
+	uring->_fd = fd;
+	uring->_entries = params.sq_entries;
+
+	uring->_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	uring->_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	uring->_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+	bool single_mmap = false;
+#if defined(IORING_FEAT_SINGLE_MMAP)
+	single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (single_mmap)
+	{
+		size_t size = uring->_sq_ring_size > uring->_cq_ring_size ? uring->_sq_ring_size : uring->_cq_ring_size;
+		uring->_sq_ring_size = size;
+		uring->_cq_ring_size = size;
+	}
+#endif
+
+	uring->_sq_ring = mmap(0, uring->_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	uring->_cq_ring = single_mmap ? uring->_sq_ring :
+		mmap(0, uring->_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+	void* sqes = mmap(0, uring->_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	uring->_sqes = sqes == MAP_FAILED ? 0 : static_cast<io_uring_sqe*>(sqes);
+
+	if (uring->_sq_ring == MAP_FAILED || uring->_cq_ring == MAP_FAILED || !uring->_sqes)
+	{
+		_ga_io_uring_destroy(uring);
+		return 0;
+	}
+
+	char* sq = static_cast<char*>(uring->_sq_ring);
+	uring->_sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	uring->_sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	uring->_sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	uring->_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+	char* cq = static_cast<char*>(uring->_cq_ring);
+	uring->_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	uring->_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	uring->_cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	uring->_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+	return uring;
+}
+
+static void _ga_io_uring_destroy(ga_io_uring_t* uring)
+{
+	if (uring->_sqes)
+	{
+		munmap(uring->_sqes, uring->_sqes_size);
+	}
+	if (uring->_cq_ring && uring->_cq_ring != MAP_FAILED && uring->_cq_ring != uring->_sq_ring)
+	{
+		munmap(uring->_cq_ring, uring->_cq_ring_size);
+	}
+	if (uring->_sq_ring && uring->_sq_ring != MAP_FAILED)
+	{
+		munmap(uring->_sq_ring, uring->_sq_ring_size);
+	}
+	close(uring->_fd);
+	delete uring;
+}
+
+/* Returns the next free submission, or null if the ring is full. */
+static io_uring_sqe* _ga_io_uring_get_sqe(ga_io_uring_t* uring)
+{
+	unsigned tail = *uring->_sq_tail;
+	unsigned head = __atomic_load_n(uring->_sq_head, __ATOMIC_ACQUIRE);
+	if (tail - head >= uring->_entries)
+	{
+		return 0;
+	}
+
+	io_uring_sqe* sqe = &uring->_sqes[tail & *uring->_sq_mask];
+	memset(sqe, 0, sizeof(*sqe));
+	return sqe;
+}
+
+/* Hands the submission from _ga_io_uring_get_sqe to the kernel. */
+static void _ga_io_uring_push_sqe(ga_io_uring_t* uring)
+{
+	unsigned tail = *uring->_sq_tail;
+	unsigned index = tail & *uring->_sq_mask;
+	uring->_sq_array[index] = index;
+	__atomic_store_n(uring->_sq_tail, tail + 1, __ATOMIC_RELEASE);
+	uring->_to_submit++;
+}
+
+static void _ga_io_uring_thread(ga_io_impl_t* impl)
+{
+	ga_io_uring_t* uring = impl->_uring;
+
+	/* Open requests waiting for room in the ring. */
+	std::vector<ga_io_request_t*> backlog;
+	std::vector<ga_io_request_t*> in_flight;
+	bool poll_armed = false;
+	bool terminate = false;
+
+	for (;;)
+	{
+		/* New requests signal the eventfd, which completes this poll. */
+		if (!poll_armed)
+		{
+			io_uring_sqe* sqe = _ga_io_uring_get_sqe(uring);
+			if (sqe)
+			{
+				sqe->opcode = IORING_OP_POLL_ADD;
+				sqe->fd = impl->_event_fd;
+				sqe->poll_events = POLLIN;
+				sqe->user_data = 0;
+				_ga_io_uring_push_sqe(uring);
+				poll_armed = true;
+			}
+		}
+
+		ga_io_request_t* request;
+		{
+			std::lock_guard<std::mutex> lock(impl->_mutex);
+			request = impl->_head;
+			impl->_head = 0;
+			impl->_tail = 0;
+			terminate = impl->_terminate;
+		}
+
+		/* Opening blocks, but only briefly; only the reads go through the ring. */
+		while (request)
+		{
+			ga_io_request_t* next = request->_next;
+			if (!_ga_io_open(request))
+			{
+				_ga_io_finish(request, -1);
+				ga_job::complete_external(&request->_counter);
+			}
+			else if (request->_size == 0)
+			{
+				_ga_io_finish(request, 0);
+				ga_job::complete_external(&request->_counter);
+			}
+			else
+			{
+				backlog.push_back(request);
+			}
+			request = next;
+		}
+
+		/* Keep one entry back for the poll. */
+		size_t submitted = 0;
+		while (submitted < backlog.size() && in_flight.size() + 1 < uring->_entries)
+		{
+			io_uring_sqe* sqe = _ga_io_uring_get_sqe(uring);
+			if (!sqe)
+			{
+				break;
+			}
+
+			ga_io_request_t* r = backlog[submitted++];
+			r->_iov.iov_base = r->_buffer + r->_done;
+			r->_iov.iov_len = r->_size - r->_done;
+			sqe->opcode = IORING_OP_READV;
+			sqe->fd = r->_fd;
+			sqe->addr = reinterpret_cast<uint64_t>(&r->_iov);
+			sqe->len = 1;
+			sqe->off = r->_offset + r->_done;
+			sqe->user_data = reinterpret_cast<uint64_t>(r);
+			_ga_io_uring_push_sqe(uring);
+			in_flight.push_back(r);
+		}
+		backlog.erase(backlog.begin(), backlog.begin() + submitted);
+
+		if (terminate && in_flight.empty() && backlog.empty())
+		{
+			break;
+		}
+
+		int result = int(syscall(__NR_io_uring_enter, uring->_fd, uring->_to_submit, 1, IORING_ENTER_GETEVENTS, 0, 0));
+		if (result < 0)
+		{
+			int error = errno;
+			if (error != EINTR && error != EAGAIN && error != EBUSY)
+			{
+				fprintf(stderr, "ga_io: io_uring_enter failed (%s); using blocking reads\n", strerror(error));
+
+				/* Send new requests to the queue from here on. */
+				{
+					std::lock_guard<std::mutex> lock(impl->_mutex);
+					impl->_uring_failed = true;
+				}
+
+				/*
+				** Nothing more will come back from the ring, so finish what it
+				** had with blocking reads from where each left off.
+				*/
+				backlog.insert(backlog.end(), in_flight.begin(), in_flight.end());
+				for (ga_io_request_t* r : backlog)
+				{
+					_ga_io_read_rest(r);
+					ga_job::complete_external(&r->_counter);
+				}
+
+				_ga_io_pool_thread(impl);
+				return;
+			}
+			continue;
+		}
+		uring->_to_submit -= unsigned(result) < uring->_to_submit ? unsigned(result) : uring->_to_submit;
+
+		unsigned head = *uring->_cq_head;
+		unsigned tail = __atomic_load_n(uring->_cq_tail, __ATOMIC_ACQUIRE);
+		while (head != tail)
+		{
+			io_uring_cqe cqe = uring->_cqes[head & *uring->_cq_mask];
+			++head;
+
+			if (cqe.user_data == 0)
+			{
+				uint64_t count;
+				ssize_t got = ::read(impl->_event_fd, &count, sizeof(count));
+				(void)got;
+				poll_armed = false;
+				continue;
+			}
+
+			ga_io_request_t* r = reinterpret_cast<ga_io_request_t*>(cqe.user_data);
+			in_flight.erase(std::find(in_flight.begin(), in_flight.end(), r));
+
+			if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+			{
+				backlog.push_back(r);
+			}
+			else if (cqe.res < 0)
+			{
+				_ga_io_finish(r, -1);
+				ga_job::complete_external(&r->_counter);
+			}
+			else
+			{
+				/* Short reads go around again for the rest. */
+				r->_done += size_t(cqe.res);
+				if (cqe.res > 0 && r->_done < r->_size)
+				{
+					backlog.push_back(r);
+				}
+				else
+				{
+					_ga_io_finish(r, int64_t(r->_done));
+					ga_job::complete_external(&r->_counter);
+				}
+			}
+		}
+		__atomic_store_n(uring->_cq_head, head, __ATOMIC_RELEASE);
+	}
+}
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+** Asynchronous file reads for the job system.
+**
+** Reads are handed to a dedicated I/O thread driving io_uring where the
+** kernel has it, and to a small pool of threads doing blocking reads
+** otherwise. A job that reads suspends its fiber until the data arrives, so
+** workers run other jobs instead of blocking on disk; the main thread runs
+** jobs while it waits. Before startup, or from any other thread, reads
+** block the caller.
+*/
+class ga_io
+{
+public:
+	/* thread_count sizes the fallback pool. Call after ga_job::startup. */
+	static void startup(int thread_count = 2);
+	static void shutdown();
+
+	/* Reads a whole file into contents. Returns false on failure. */
+	static bool read_file(const char* path, std::string& contents);
+
+	/* Reads up to size bytes at offset. Returns bytes read, or -1 on failure. */
+	static int64_t read(const char* path, uint64_t offset, void* buffer, size_t size);
+
+private:
+	static void* _impl;
+};
@@ -9,12 +9,21 @@
 
 #include "ga_job.h"
 
-#include "ga_condvar.h"
+#include "ga_cpu_topology.h"
+#include "ga_deque.h"
+#include "ga_eventcount.h"
 #include "ga_fiber.h"
+#include "ga_frame_arena.h"
 #include "ga_intpool.h"
+#include "ga_job_trace.h"
+#include "ga_mpmc_queue.h"
 #include "ga_queue.h"
 
 #include <atomic>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -26,70 +35,311 @@ struct ga_job_instance_t
 
 	ga_job_decl_t* _decl;
 
-	int32_t* _waiting_count;
+	ga_job_counter* _waiting_count;
 
+	/* Next job waiting on the same counter. */
+	ga_job_instance_t* _next_waiter;
+
+	ga_job_stack_t _stack;
 	int _pool_index;
 
+	/* Created the first time this instance is used. */
 	ga_fiber _fiber;
 	ga_fiber* _parent_fiber;
 };
 
+/* Usable stack size of each ga_job_stack_t. */
+static const size_t k_ga_job_stack_sizes[k_job_stack_count] =
+{
+	64 * 1024,
+	1024 * 1024,
+};
+
+/*
+** Shared state of one parallel_for call, on the caller's stack. Split off
+** ranges come from a fixed set of slots; once those run out, ranges just
+** stop splitting.
+*/
+static const int k_ga_job_parallel_for_max_jobs = 128;
+
+struct ga_job_parallel_for_t;
+struct ga_job_system_impl_t;
+
+/* A thread's scratch memory, rewound the first time it's used each frame. */
+struct ga_job_scratch_t
+{
+	ga_frame_arena* _arena;
+	uint64_t _frame;
+};
+
+struct ga_job_parallel_for_range_t
+{
+	ga_job_parallel_for_t* _loop;
+	int _begin;
+	int _end;
+};
+
+struct ga_job_parallel_for_t
+{
+	ga_job_system_impl_t* _impl;
+
+	ga_job_range_function_t _func;
+	void* _data;
+	int _grain;
+	ga_job_priority_t _priority;
+	ga_job_stack_t _stack;
+
+	std::atomic<int> _job_count;
+	ga_job_counter _counter;
+
+	ga_job_parallel_for_range_t _ranges[k_ga_job_parallel_for_max_jobs];
+	ga_job_decl_t _decls[k_ga_job_parallel_for_max_jobs];
+};
+
+/* Decls pushed to a shared queue in one reservation. */
+static const int k_ga_job_push_batch_size = 64;
+
+/* Lock bit in ga_job_counter::_count. */
+static const int32_t k_ga_job_counter_lock = INT32_MIN;
+
 struct ga_job_system_impl_t
 {
-	ga_job_system_impl_t(int queue_size, int fiber_count) :
+	ga_job_system_impl_t(int fiber_count, int large_fiber_count) :
 		_main_thread(std::this_thread::get_id()),
-		_job_queue(queue_size),
-		_job_instance_pool(fiber_count),
-		_wait_queue(queue_size)
+		_ready_queue(fiber_count + large_fiber_count + 1)
 	{}
 
 	std::thread::id _main_thread;
+	ga_fiber _main_fiber;
+
+	/* Jobs submitted from outside the workers, i.e. the main thread. */
+	ga_mpmc_queue* _job_queues[k_job_priority_count];
 
-	ga_queue _job_queue;
+	/*
+	** Jobs that didn't fit in a full shared queue, pushed by callers that
+	** can't run them inline. Checked after the shared queue.
+	*/
+	std::mutex _overflow_mutex[k_job_priority_count];
+	std::deque<ga_job_decl_t*> _overflow[k_job_priority_count];
+	std::atomic<int> _overflow_count[k_job_priority_count];
 
-	ga_intpool _job_instance_pool;
-	ga_job_instance_t* _job_instance_data;
+	/* Per-worker job decls. Owners push and pop, other workers steal. */
+	std::vector<ga_deque*> _worker_deques[k_job_priority_count];
+	int _worker_count;
 
-	ga_queue _wait_queue;
+	/* Logical CPU of each worker, and whether workers are pinned to them. */
+	std::vector<int> _worker_cpus;
+	bool _pin_workers;
+
+	/*
+	** Victims for each worker to steal from, those sharing its L3 first.
+	** The extra last entry is for the main thread.
+	*/
+	std::vector<std::vector<int>> _steal_order;
+
+	/* Job instances, and the fibers they run on, for each stack class. */
+	ga_intpool* _job_instance_pools[k_job_stack_count];
+	ga_job_instance_t* _job_instance_data[k_job_stack_count];
+
+	/* Suspended jobs whose counter has reached zero. */
+	ga_queue _ready_queue;
 
 	std::vector<std::thread*> _worker_threads;
 
-	ga_condvar _work_added;
-	ga_condvar _work_exhausted;
+	/* Idle workers park here. Woken once per queued job. */
+	ga_eventcount _work_available;
+
+	/*
+	** The main thread parks here while waiting on a counter, when it has no
+	** jobs to run. It's woken when that counter hits zero, or for new jobs
+	** when no worker is asleep to take them.
+	*/
+	ga_eventcount _main_wake;
+	std::atomic<ga_job_counter*> _main_wait_counter;
+
+	/*
+	** Background jobs only start while this frame's budget lasts, but at
+	** least one starts each frame.
+	*/
+	std::atomic<int64_t> _background_budget_ns;
+	std::atomic<int64_t> _background_time_ns;
+	std::atomic<int> _background_started;
+
+	/* Scratch arenas for each worker, then the main thread. */
+	std::vector<ga_job_scratch_t> _scratch;
+	std::atomic<uint64_t> _frame_index;
 
-	bool _terminate;
+	/* Times we had to back off for lack of room. See ga_job_stats. */
+	std::atomic<uint64_t> _fiber_pool_exhausted;
+	std::atomic<uint64_t> _queue_full;
+
+	std::atomic_bool _terminate;
 };
 
-static int _ga_job_instance_thread_worker(void* data);
-static bool _ga_job_schedule(ga_job_system_impl_t* impl, ga_fiber* parent_fiber);
+/*
+** A worker that has picked this many higher priority jobs in a row tries
+** background work first, so a steady stream of frame work can't starve it.
+*/
+static const int k_ga_job_background_starvation_limit = 32;
+
+static const size_t k_ga_job_scratch_block_size = 256 * 1024;
+
+/* Index of the worker running on this thread, or -1 if not a worker. */
+static thread_local int _ga_job_worker_index = -1;
+
+/* Higher priority jobs this worker has picked since its last background job. */
+static thread_local int _ga_job_background_skips = 0;
+
+/*
+** A job this thread took but couldn't start because its fiber pool was
+** exhausted and the shared queue had no room to put it back.
+*/
+static thread_local ga_job_decl_t* _ga_job_held = 0;
+
+static int _ga_job_instance_thread_worker(ga_job_system_impl_t* impl, int worker_index);
+static ga_job_instance_t* _ga_job_find(ga_job_system_impl_t* impl);
+static bool _ga_job_pop(ga_job_system_impl_t* impl, int priority, ga_job_decl_t** decl);
+static bool _ga_job_pop_background(ga_job_system_impl_t* impl, ga_job_decl_t** decl);
+static bool _ga_job_steal(ga_job_system_impl_t* impl, int priority, ga_job_decl_t** decl);
 static void _ga_job_run(ga_job_system_impl_t* impl, ga_fiber* parent_fiber, ga_job_instance_t* job);
+static void _ga_job_suspend(ga_job_system_impl_t* impl, ga_job_instance_t* job);
+static void _ga_job_push(ga_job_system_impl_t* impl, ga_job_decl_t* decls, int decl_count, ga_job_counter* counter);
+static void _ga_job_push_shared(ga_job_system_impl_t* impl, int priority, void** decls, int decl_count);
+static void _ga_job_push_overflow(ga_job_system_impl_t* impl, int priority, void** decls, int decl_count);
+static bool _ga_job_pop_overflow(ga_job_system_impl_t* impl, int priority, ga_job_decl_t** decl);
+static void _ga_job_return_held(ga_job_system_impl_t* impl);
+static void _ga_job_report(std::atomic<uint64_t>* counter, const char* message);
+static void _ga_job_counter_decrement(ga_job_system_impl_t* impl, ga_job_counter* counter);
+static int32_t _ga_job_counter_lock(ga_job_counter* counter);
+static void _ga_job_counter_unlock(ga_job_counter* counter);
+static void _ga_job_wake(ga_job_system_impl_t* impl, int count);
+static void _ga_job_parallel_for_worker(void* data);
+static bool _ga_job_parallel_for_should_split(ga_job_system_impl_t* impl, int priority);
 static void _ga_job_fiber_worker(void* data);
 
 void ga_job::startup(
 	uint32_t hardware_thread_mask,
 	int queue_size,
-	int fiber_count)
+	int fiber_count,
+	int large_fiber_count)
+{
+	ga_cpu_topology topology;
+
+	ga_job_config config;
+	config._queue_size = queue_size;
+	config._fiber_count = fiber_count;
+	config._large_fiber_count = large_fiber_count;
+	for (int i = 0; i < int(topology.get_cpus().size()) && i < 32; ++i)
+	{
+		if ((hardware_thread_mask & (1u << i)) != 0)
+		{
+			config._worker_cpus.push_back(topology.get_cpus()[i]._id);
+		}
+	}
+
+	startup(config);
+}
+
+void ga_job::startup(const ga_job_config& config)
 {
-	ga_job_system_impl_t* impl = new ga_job_system_impl_t(queue_size, fiber_count);
+	int queue_size = config._queue_size;
+	int fiber_count = config._fiber_count;
+	int large_fiber_count = config._large_fiber_count;
+
+	ga_job_system_impl_t* impl = new ga_job_system_impl_t(fiber_count, large_fiber_count);
 
 	impl->_terminate = false;
+	impl->_main_wait_counter = 0;
+	impl->_fiber_pool_exhausted = 0;
+	impl->_queue_full = 0;
+	impl->_frame_index = 0;
+	impl->_background_budget_ns = INT64_MAX;
+	impl->_background_time_ns = 0;
+	impl->_background_started = 0;
 
-	impl->_job_instance_data = new ga_job_instance_t[fiber_count];
-	for (int i = 0; i < fiber_count; ++i)
+	/* The main thread runs jobs while it waits, so it needs a fiber too. */
+	impl->_main_fiber = ga_fiber::convert_thread(0);
+	GA_JOB_TRACE_THREAD("main");
+
+	/*
+	** Fibers are created lazily, so memory follows the number of jobs
+	** actually in flight rather than the pool size.
+	*/
+	int instance_counts[k_job_stack_count] = { fiber_count, large_fiber_count };
+	for (int c = 0; c < k_job_stack_count; ++c)
 	{
-		ga_job_instance_t* instance = &impl->_job_instance_data[i];
-		instance->_fiber = ga_fiber(_ga_job_fiber_worker, instance, 64 * 1024);
-		instance->_pool_index = i;
+		impl->_job_instance_pools[c] = new ga_intpool(instance_counts[c]);
+		impl->_job_instance_data[c] = new ga_job_instance_t[instance_counts[c]];
+		for (int i = 0; i < instance_counts[c]; ++i)
+		{
+			impl->_job_instance_data[c][i]._stack = ga_job_stack_t(c);
+			impl->_job_instance_data[c][i]._pool_index = i;
+			impl->_job_instance_data[c][i]._waiting_count = 0;
+		}
 	}
 
-	int hardware_thread_count = std::thread::hardware_concurrency();
-	for (int i = 0; i < hardware_thread_count; ++i)
+	ga_cpu_topology topology;
+
+	impl->_worker_cpus = config._worker_cpus;
+	if (impl->_worker_cpus.empty())
 	{
-		if ((hardware_thread_mask & (1 << i)) != 0)
+		for (auto& cpu : topology.get_cpus())
 		{
-			impl->_worker_threads.push_back(new std::thread(_ga_job_instance_thread_worker, impl));
+			impl->_worker_cpus.push_back(cpu._id);
 		}
 	}
+	impl->_worker_count = int(impl->_worker_cpus.size());
+	impl->_pin_workers = config._pin_workers;
+
+	impl->_scratch.resize(impl->_worker_count + 1);
+	for (auto& scratch : impl->_scratch)
+	{
+		scratch._arena = new ga_frame_arena(k_ga_job_scratch_block_size);
+		scratch._frame = 0;
+	}
+
+	/*
+	** Stealing from a worker on the same L3 moves data that's likely still
+	** in cache. Within each group, start just after ourselves so thieves
+	** spread out.
+	*/
+	impl->_steal_order.resize(impl->_worker_count + 1);
+	for (int w = 0; w <= impl->_worker_count; ++w)
+	{
+		int l3 = w < impl->_worker_count ? topology.get_l3(impl->_worker_cpus[w]) : -1;
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			for (int i = 1; i <= impl->_worker_count; ++i)
+			{
+				int victim = (w + i) % (impl->_worker_count + 1);
+				if (victim == w || victim == impl->_worker_count)
+				{
+					continue;
+				}
+				bool shared = l3 >= 0 && topology.get_l3(impl->_worker_cpus[victim]) == l3;
+				if (shared == (pass == 0))
+				{
+					impl->_steal_order[w].push_back(victim);
+				}
+			}
+		}
+	}
+
+	for (int p = 0; p < k_job_priority_count; ++p)
+	{
+		impl->_job_queues[p] = new ga_mpmc_queue(queue_size);
+		impl->_overflow_count[p] = 0;
+		for (int i = 0; i < impl->_worker_count; ++i)
+		{
+			impl->_worker_deques[p].push_back(new ga_deque(queue_size));
+		}
+	}
+
+	/* Deques must all exist before any worker starts stealing. */
+	for (int i = 0; i < impl->_worker_count; ++i)
+	{
+		impl->_worker_threads.push_back(new std::thread(_ga_job_instance_thread_worker, impl, i));
+	}
 
 	_impl = impl;
 }
@@ -99,130 +349,777 @@ void ga_job::shutdown()
 	ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(_impl);
 
 	impl->_terminate = true;
-	impl->_work_added.wake_all();
+	impl->_work_available.notify_all();
 	for (auto& t : impl->_worker_threads)
 	{
 		t->join();
 		delete t;
 	}
 
-	delete[] impl->_job_instance_data;
+	for (int p = 0; p < k_job_priority_count; ++p)
+	{
+		for (auto& d : impl->_worker_deques[p])
+		{
+			delete d;
+		}
+		delete impl->_job_queues[p];
+	}
+
+	for (int c = 0; c < k_job_stack_count; ++c)
+	{
+		delete[] impl->_job_instance_data[c];
+		delete impl->_job_instance_pools[c];
+	}
+
+	for (auto& scratch : impl->_scratch)
+	{
+		delete scratch._arena;
+	}
+
+	impl->_main_fiber.revert_thread();
 }
 
-void ga_job::run(ga_job_decl_t* decls, int decl_count, int32_t* counter)
+void ga_job::run(ga_job_decl_t* decls, int decl_count, ga_job_counter* counter)
 {
-	*counter = decl_count;
+	ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(_impl);
+
+	counter->_count.fetch_add(decl_count);
+	_ga_job_push(impl, decls, decl_count, counter);
+}
 
+void ga_job::run_after(
+	ga_job_counter* counter,
+	ga_job_decl_t* decls,
+	int decl_count,
+	ga_job_counter* continuation_counter)
+{
 	ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(_impl);
-	for (int i = 0; i < decl_count; ++i)
+
+	continuation_counter->_count.fetch_add(decl_count);
+	continuation_counter->_continuation_decls = decls;
+	continuation_counter->_continuation_decl_count = decl_count;
+
+	/* As with waiting jobs, either the final decrement sees us or we see it. */
+	bool ready = _ga_job_counter_lock(counter) == 0;
+	if (!ready)
 	{
-		decls[i]._pending_count = counter;
-		impl->_job_queue.push(decls + i);
+		continuation_counter->_next_continuation = counter->_continuations;
+		counter->_continuations = continuation_counter;
+	}
+	_ga_job_counter_unlock(counter);
+
+	if (ready)
+	{
+		_ga_job_push(impl, decls, decl_count, continuation_counter);
+	}
+}
+
+void ga_job::begin_frame()
+{
+	ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(_impl);
+
+	GA_JOB_TRACE_EVENT(k_job_trace_frame, 0, 0);
+
+	/* Each thread rewinds its own scratch arena when it next allocates. */
+	impl->_frame_index++;
+
+	bool over_budget = impl->_background_time_ns >= impl->_background_budget_ns;
+	impl->_background_time_ns = 0;
+	impl->_background_started = 0;
+
+	/* Workers may have parked with background work left over. */
+	if (over_budget)
+	{
+		_ga_job_wake(impl, impl->_worker_count);
+	}
+}
+
+void* ga_job::alloc_scratch(size_t size, size_t alignment)
+{
+	ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(_impl);
+
+	/*
+	** Only the owning thread allocates or rewinds a scratch arena, so other
+	** threads can keep using what they got from it until the frame ends.
+	*/
+	int index = _ga_job_worker_index >= 0 ? _ga_job_worker_index : impl->_worker_count;
+	ga_job_scratch_t& scratch = impl->_scratch[index];
+
+	uint64_t frame = impl->_frame_index.load(std::memory_order_relaxed);
+	if (scratch._frame != frame)
+	{
+		scratch._arena->reset();
+		scratch._frame = frame;
+	}
+
+	return scratch._arena->alloc(size, alignment);
+}
+
+int ga_job::get_thread_index()
+{
+	ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(_impl);
+	if (!impl)
+	{
+		return 0;
 	}
+	return _ga_job_worker_index >= 0 ? _ga_job_worker_index : impl->_worker_count;
+}
+
+int ga_job::get_thread_count()
+{
+	ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(_impl);
+	return impl ? impl->_worker_count + 1 : 1;
+}
+
+bool ga_job::is_job_thread()
+{
+	ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(_impl);
+	if (!impl)
+	{
+		return true;
+	}
+	return _ga_job_worker_index >= 0 || std::this_thread::get_id() == impl->_main_thread;
+}
+
+ga_job_stats ga_job::get_stats()
+{
+	ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(_impl);
+
+	ga_job_stats stats;
+	stats._fiber_pool_exhausted = impl->_fiber_pool_exhausted;
+	stats._queue_full = impl->_queue_full;
+	return stats;
+}
+
+void ga_job::set_background_budget(std::chrono::microseconds budget)
+{
+	ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(_impl);
+	impl->_background_budget_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(budget).count();
+}
+
+void ga_job::add_external(ga_job_counter* counter, int count)
+{
+	counter->_count.fetch_add(count);
+}
 
-	impl->_work_added.wake_all();
+void ga_job::complete_external(ga_job_counter* counter)
+{
+	ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(_impl);
+	_ga_job_counter_decrement(impl, counter);
 }
 
-void ga_job::wait(int32_t* counter)
+void ga_job::wait(ga_job_counter* counter)
 {
-	if (*counter > 0)
+	if (counter->_count.load() != 0)
 	{
 		/*
-		** If we're not the main thread, assume we're waiting from within a job.
-		** In this case, push the current job onto the wait list, and reschedule.
+		** If we're on a job's fiber, mark the current job as waiting and switch
+		** back to the scheduler, which puts it on the counter's wait list. It
+		** will be moved to the ready queue when the counter hits zero. Thread fibers
+		** carry no data; job fibers carry their instance.
 		*/
 		ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(_impl);
-		if (std::this_thread::get_id() != impl->_main_thread)
+		ga_job_instance_t* job = static_cast<ga_job_instance_t*>(ga_fiber::get_data());
+		if (job)
 		{
-			ga_job_instance_t* job = static_cast<ga_job_instance_t*>(ga_fiber::get_data());
 			job->_waiting_count = counter;
-			impl->_wait_queue.push(job);
-
 			ga_fiber::switch_to(*job->_parent_fiber);
 		}
 		/*
-		** Otherwise, in the main thread, block until jobs are complete.
+		** Otherwise, we're on the main thread. Rather than idle, run jobs here
+		** until the counter hits zero. Sleep only when there's nothing to run.
 		*/
 		else
 		{
-			while (*counter > 0)
+			impl->_main_wait_counter = counter;
+			while (counter->_count.load() != 0)
 			{
-				impl->_work_exhausted.wait();
+				job = _ga_job_find(impl);
+				if (!job && _ga_job_held)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+				if (!job)
+				{
+					uint32_t key = impl->_main_wake.prepare_wait();
+					if (counter->_count.load() != 0 && !(job = _ga_job_find(impl)))
+					{
+						GA_JOB_TRACE_EVENT(k_job_trace_park, 0, 0);
+						impl->_main_wake.commit_wait(key);
+						GA_JOB_TRACE_EVENT(k_job_trace_unpark, 0, 0);
+						continue;
+					}
+					impl->_main_wake.cancel_wait();
+				}
+
+				if (job)
+				{
+					_ga_job_run(impl, &impl->_main_fiber, job);
+				}
 			}
+			impl->_main_wait_counter = 0;
+
+			/* Don't sit on a job once we go back to the game. */
+			_ga_job_return_held(impl);
 		}
 	}
 }
 
-static int _ga_job_instance_thread_worker(void* data)
+void ga_job::parallel_for(int begin, int end, int grain, ga_job_range_function_t func, void* data)
+{
+	grain = grain > 1 ? grain : 1;
+	if (end - begin <= grain)
+	{
+		if (end > begin)
+		{
+			func(begin, end, data);
+		}
+		return;
+	}
+
+	ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(_impl);
+
+	/* Split off ranges run at the caller's priority, on the same size stack. */
+	ga_job_instance_t* caller = static_cast<ga_job_instance_t*>(ga_fiber::get_data());
+
+	ga_job_parallel_for_t loop;
+	loop._impl = impl;
+	loop._priority = caller ? caller->_decl->_priority : k_job_priority_normal;
+	loop._stack = caller ? caller->_decl->_stack : k_job_stack_small;
+	loop._func = func;
+	loop._data = data;
+	loop._grain = grain;
+
+	/* One range per worker, plus one for the caller, to begin with. */
+	int64_t count = int64_t(end) - begin;
+	int64_t range_count = int64_t(impl->_worker_count) + 1;
+	range_count = range_count < (count + grain - 1) / grain ? range_count : (count + grain - 1) / grain;
+	range_count = range_count < k_ga_job_parallel_for_max_jobs ? range_count : k_ga_job_parallel_for_max_jobs;
+	loop._job_count = int(range_count);
+
+	for (int i = 0; i < range_count; ++i)
+	{
+		loop._ranges[i]._loop = &loop;
+		loop._ranges[i]._begin = int(begin + count * i / range_count);
+		loop._ranges[i]._end = int(begin + count * (i + 1) / range_count);
+		loop._decls[i]._entry = _ga_job_parallel_for_worker;
+		loop._decls[i]._data = &loop._ranges[i];
+		loop._decls[i]._priority = loop._priority;
+		loop._decls[i]._stack = loop._stack;
+	}
+
+	ga_job::run(loop._decls + 1, int(range_count) - 1, &loop._counter);
+	_ga_job_parallel_for_worker(&loop._ranges[0]);
+	ga_job::wait(&loop._counter);
+}
+
+static int _ga_job_instance_thread_worker(ga_job_system_impl_t* impl, int worker_index)
 {
-	ga_job_system_impl_t* impl = static_cast<ga_job_system_impl_t*>(data);
+	_ga_job_worker_index = worker_index;
+
+	if (impl->_pin_workers)
+	{
+		ga_cpu_topology::pin_current_thread(impl->_worker_cpus[worker_index]);
+	}
 
 	ga_fiber parent_fiber = ga_fiber::convert_thread(0);
 
-	while (!impl->_terminate)
+#if GA_JOB_TRACE
+	char trace_name[32];
+	snprintf(trace_name, sizeof(trace_name), "worker %d", worker_index);
+	GA_JOB_TRACE_THREAD(trace_name);
+#endif
+
+	for (;;)
 	{
-		if (!_ga_job_schedule(impl, &parent_fiber))
+		ga_job_instance_t* job = _ga_job_find(impl);
+
+		/* Holding a job that's waiting for a fiber. Don't sleep on it. */
+		if (!job && _ga_job_held && !impl->_terminate)
 		{
-			impl->_work_exhausted.wake_all();
-			impl->_work_added.wait_for(1000);
+			std::this_thread::yield();
+			continue;
 		}
+
+		/*
+		** Nothing to do. Register as a sleeper, then look once more so work
+		** queued in between isn't missed, and park until notified.
+		*/
+		if (!job)
+		{
+			uint32_t key = impl->_work_available.prepare_wait();
+			job = _ga_job_find(impl);
+			if (!job && !impl->_terminate)
+			{
+				GA_JOB_TRACE_EVENT(k_job_trace_park, 0, 0);
+				impl->_work_available.commit_wait(key);
+				GA_JOB_TRACE_EVENT(k_job_trace_unpark, 0, 0);
+				continue;
+			}
+			impl->_work_available.cancel_wait();
+		}
+
+		if (!job)
+		{
+			break;
+		}
+
+		_ga_job_run(impl, &parent_fiber, job);
 	}
 
 	return 0;
 }
 
-static bool _ga_job_schedule(ga_job_system_impl_t* impl, ga_fiber* parent_fiber)
+static ga_job_instance_t* _ga_job_find(ga_job_system_impl_t* impl)
 {
-	/* Check for waiting jobs that are ready to run. */
+	/* Resume suspended jobs whose counters have reached zero first. */
 	ga_job_instance_t* job;
-	int retry_wait_count = impl->_wait_queue.get_count();
-	while (retry_wait_count-- > 0 && impl->_wait_queue.pop((void**)&job))
+	if (impl->_ready_queue.pop((void**)&job))
 	{
-		if (job->_waiting_count == 0 || job->_waiting_count[0] == 0)
-		{
-			_ga_job_run(impl, parent_fiber, job);
-			return true;
-		}
-		else
+		return job;
+	}
+
+	/*
+	** Then new jobs, highest priority first. The main thread only waits on
+	** frame work, so it leaves background jobs to the workers.
+	*/
+	ga_job_decl_t* decl = _ga_job_held;
+	bool allow_background = _ga_job_worker_index >= 0;
+	bool found = decl != 0;
+	_ga_job_held = 0;
+
+	found = found || (allow_background &&
+		_ga_job_background_skips >= k_ga_job_background_starvation_limit &&
+		_ga_job_pop_background(impl, &decl));
+
+	for (int p = 0; !found && p < k_job_priority_background; ++p)
+	{
+		if (_ga_job_pop(impl, p, &decl))
 		{
-			impl->_wait_queue.push(job);
+			found = true;
+			++_ga_job_background_skips;
 		}
 	}
 
-	/* Look for queued jobs. */
-	ga_job_decl_t* decl;
-	if (impl->_job_queue.pop((void**)&decl))
+	if (!found && allow_background)
 	{
-		int ga_job_index = impl->_job_instance_pool.alloc();
+		found = _ga_job_pop_background(impl, &decl);
+	}
+
+	if (found)
+	{
+		int stack = decl->_stack;
+		int ga_job_index = impl->_job_instance_pools[stack]->alloc();
 
-		job = &impl->_job_instance_data[ga_job_index];
+		/*
+		** Every fiber of this size is busy. Put the job back for whoever
+		** frees one next, or hold on to it if there's no room.
+		*/
+		if (ga_job_index < 0)
+		{
+			_ga_job_report(&impl->_fiber_pool_exhausted, "fiber pool exhausted; raise the fiber count");
+			if (!impl->_job_queues[decl->_priority]->push(decl))
+			{
+				_ga_job_held = decl;
+			}
+			return 0;
+		}
+
+		job = &impl->_job_instance_data[stack][ga_job_index];
 		job->_decl = decl;
-		job->_pool_index = ga_job_index;
+		if (!job->_fiber.is_valid())
+		{
+			job->_fiber = ga_fiber(_ga_job_fiber_worker, job, k_ga_job_stack_sizes[stack]);
+		}
+
+		return job;
+	}
+
+	return 0;
+}
 
-		_ga_job_run(impl, parent_fiber, job);
+static bool _ga_job_pop(ga_job_system_impl_t* impl, int priority, ga_job_decl_t** decl)
+{
+	/* Our own jobs first, then shared, then other workers'. */
+	int worker_index = _ga_job_worker_index;
+	return (worker_index >= 0 && impl->_worker_deques[priority][worker_index]->pop((void**)decl)) ||
+		impl->_job_queues[priority]->pop((void**)decl) ||
+		_ga_job_pop_overflow(impl, priority, decl) ||
+		_ga_job_steal(impl, priority, decl);
+}
+
+static bool _ga_job_pop_background(ga_job_system_impl_t* impl, ga_job_decl_t** decl)
+{
+	if (impl->_background_started > 0 && impl->_background_time_ns >= impl->_background_budget_ns)
+	{
+		return false;
+	}
 
+	if (_ga_job_pop(impl, k_job_priority_background, decl))
+	{
+		++impl->_background_started;
+		_ga_job_background_skips = 0;
 		return true;
 	}
+	return false;
+}
 
-	return impl->_wait_queue.get_count() != 0;
+static bool _ga_job_steal(ga_job_system_impl_t* impl, int priority, ga_job_decl_t** decl)
+{
+	int worker_index = _ga_job_worker_index;
+	auto& victims = impl->_steal_order[worker_index >= 0 ? worker_index : impl->_worker_count];
+	for (int victim : victims)
+	{
+		if (impl->_worker_deques[priority][victim]->steal((void**)decl))
+		{
+			GA_JOB_TRACE_EVENT(k_job_trace_steal, reinterpret_cast<const void*>((*decl)->_entry), 0);
+			return true;
+		}
+	}
+	return false;
 }
 
 static void _ga_job_run(ga_job_system_impl_t* impl, ga_fiber* parent_fiber, ga_job_instance_t* job)
 {
+	/* Resumed jobs still point at the counter they waited on. */
+	GA_JOB_TRACE_EVENT(job->_waiting_count ? k_job_trace_resume : k_job_trace_begin,
+		reinterpret_cast<const void*>(job->_decl->_entry), job);
+
 	job->_parent_fiber = parent_fiber;
 	job->_waiting_count = 0;
 
-	ga_fiber::switch_to(job->_fiber);
+	/* Background jobs are charged against the frame's budget. */
+	if (job->_decl->_priority == k_job_priority_background)
+	{
+		auto start = std::chrono::steady_clock::now();
+		ga_fiber::switch_to(job->_fiber);
+		impl->_background_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+	else
+	{
+		ga_fiber::switch_to(job->_fiber);
+	}
+
+	/*
+	** The job suspended itself. Only now that we're off its fiber is it safe
+	** for another thread to pick it up and resume it.
+	*/
+	if (job->_waiting_count)
+	{
+		GA_JOB_TRACE_EVENT(k_job_trace_suspend, reinterpret_cast<const void*>(job->_decl->_entry), job);
+		_ga_job_suspend(impl, job);
+	}
+	else
+	{
+		GA_JOB_TRACE_EVENT(k_job_trace_end, reinterpret_cast<const void*>(job->_decl->_entry), job);
+
+		ga_job_counter* counter = job->_decl->_pending_count;
+
+		impl->_job_instance_pools[job->_stack]->free(job->_pool_index);
+
+		_ga_job_counter_decrement(impl, counter);
+	}
+}
+
+static void _ga_job_suspend(ga_job_system_impl_t* impl, ga_job_instance_t* job)
+{
+	ga_job_counter* counter = job->_waiting_count;
+
+	/*
+	** Check the count under the lock: either the final decrement sees us
+	** on the list, or we see that it already happened.
+	*/
+	bool ready = _ga_job_counter_lock(counter) == 0;
+	if (!ready)
+	{
+		job->_next_waiter = counter->_waiters;
+		counter->_waiters = job;
+	}
+	_ga_job_counter_unlock(counter);
+
+	if (ready)
+	{
+		impl->_ready_queue.push(job);
+	}
+}
+
+static void _ga_job_push(ga_job_system_impl_t* impl, ga_job_decl_t* decls, int decl_count, ga_job_counter* counter)
+{
+	/*
+	** Jobs spawned from inside a job go to the spawning worker's deque, so
+	** they're likely to run on the same core with a warm cache. Everything
+	** else, or anything that doesn't fit, goes to the shared queue.
+	*/
+	int worker_index = _ga_job_worker_index;
+
+	/* Runs of same priority decls bound for a shared queue go in one batch. */
+	void* batch[k_ga_job_push_batch_size];
+	int batch_count = 0;
+	int batch_priority = 0;
+
+	for (int i = 0; i < decl_count; ++i)
+	{
+		int priority = decls[i]._priority;
+		decls[i]._pending_count = counter;
+		if (worker_index >= 0 && impl->_worker_deques[priority][worker_index]->push(decls + i))
+		{
+			continue;
+		}
+
+		if (batch_count == k_ga_job_push_batch_size || (batch_count > 0 && priority != batch_priority))
+		{
+			_ga_job_push_shared(impl, batch_priority, batch, batch_count);
+			batch_count = 0;
+		}
+		batch_priority = priority;
+		batch[batch_count++] = decls + i;
+	}
 
-	if (job->_waiting_count == 0 || job->_waiting_count[0] == 0)
+	if (batch_count > 0)
 	{
-		impl->_job_instance_pool.free(job->_pool_index);
+		_ga_job_push_shared(impl, batch_priority, batch, batch_count);
+	}
+
+	_ga_job_wake(impl, decl_count);
+}
 
-		(*reinterpret_cast<std::atomic_int*>(job->_decl->_pending_count))--;
+static void _ga_job_push_shared(ga_job_system_impl_t* impl, int priority, void** decls, int decl_count)
+{
+	int pushed = impl->_job_queues[priority]->push_n(decls, decl_count);
+	if (pushed == decl_count)
+	{
+		return;
+	}
+
+	_ga_job_report(&impl->_queue_full, "job queue full; raise the queue size");
+
+	/*
+	** The queue is full. Jobs pay for what doesn't fit by running it on
+	** their own fiber, which also throttles them, as long as it would get
+	** the same size stack there and isn't background work, which has to
+	** stay within the frame's budget. Everything else, and everyone not on
+	** a job's fiber, like the scheduler finishing a counter or I/O
+	** completing one, leaves it on the overflow list.
+	*/
+	ga_job_instance_t* job = static_cast<ga_job_instance_t*>(ga_fiber::get_data());
+	if (!job || priority == k_job_priority_background)
+	{
+		_ga_job_push_overflow(impl, priority, decls + pushed, decl_count - pushed);
+		return;
+	}
+
+	for (; pushed < decl_count; ++pushed)
+	{
+		ga_job_decl_t* decl = static_cast<ga_job_decl_t*>(decls[pushed]);
+		if (decl->_stack != job->_stack)
+		{
+			_ga_job_push_overflow(impl, priority, decls + pushed, 1);
+			continue;
+		}
+		decl->_entry(decl->_data);
+		_ga_job_counter_decrement(impl, decl->_pending_count);
 	}
 }
 
-static void _ga_job_fiber_worker(void* data)
+static void _ga_job_push_overflow(ga_job_system_impl_t* impl, int priority, void** decls, int decl_count)
+{
+	std::lock_guard<std::mutex> lock(impl->_overflow_mutex[priority]);
+	for (int i = 0; i < decl_count; ++i)
+	{
+		impl->_overflow[priority].push_back(static_cast<ga_job_decl_t*>(decls[i]));
+	}
+	impl->_overflow_count[priority] += decl_count;
+}
+
+static bool _ga_job_pop_overflow(ga_job_system_impl_t* impl, int priority, ga_job_decl_t** decl)
+{
+	/* Almost always empty, so check without the lock first. */
+	if (impl->_overflow_count[priority] == 0)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(impl->_overflow_mutex[priority]);
+	if (impl->_overflow[priority].empty())
+	{
+		return false;
+	}
+	*decl = impl->_overflow[priority].front();
+	impl->_overflow[priority].pop_front();
+	impl->_overflow_count[priority]--;
+	return true;
+}
+
+static void _ga_job_return_held(ga_job_system_impl_t* impl)
+{
+	ga_job_decl_t* decl = _ga_job_held;
+	_ga_job_held = 0;
+	if (decl && !impl->_job_queues[decl->_priority]->push(decl))
+	{
+		_ga_job_push_overflow(impl, decl->_priority, (void**)&decl, 1);
+	}
+}
+
+static void _ga_job_report(std::atomic<uint64_t>* counter, const char* message)
+{
+	/* Count every time, but only complain once. */
+	if ((*counter)++ == 0)
+	{
+		std::cerr << "ga_job: " << message << std::endl;
+	}
+}
+
+static void _ga_job_counter_decrement(ga_job_system_impl_t* impl, ga_job_counter* counter)
+{
+	/* Decrements that don't finish the counter never take the lock. */
+	int32_t count = counter->_count.load();
+	for (;;)
+	{
+		if (count & k_ga_job_counter_lock)
+		{
+			count = counter->_count.load();
+		}
+		else if (count > 1)
+		{
+			if (counter->_count.compare_exchange_weak(count, count - 1))
+			{
+				return;
+			}
+		}
+		else if (counter->_count.compare_exchange_weak(count, 1 | k_ga_job_counter_lock))
+		{
+			break;
+		}
+	}
+
+	ga_job_instance_t* waiters = counter->_waiters;
+	ga_job_counter* continuations = counter->_continuations;
+	counter->_waiters = 0;
+	counter->_continuations = 0;
+
+	/*
+	** Dropping the lock and the count in one store is our last touch of the
+	** counter. If jobs were added in the meantime it isn't finished after all.
+	*/
+	int32_t locked = 1 | k_ga_job_counter_lock;
+	if (!counter->_count.compare_exchange_strong(locked, 0))
+	{
+		counter->_waiters = waiters;
+		counter->_continuations = continuations;
+		counter->_count.fetch_sub(1 | k_ga_job_counter_lock);
+		return;
+	}
+
+	/* The counter may already be gone; only compare its address. */
+	if (impl->_main_wait_counter == counter)
+	{
+		impl->_main_wake.notify(1);
+	}
+
+	int ready_count = 0;
+	while (waiters)
+	{
+		ga_job_instance_t* job = waiters;
+		waiters = job->_next_waiter;
+		impl->_ready_queue.push(job);
+		++ready_count;
+	}
+
+	if (ready_count > 0)
+	{
+		_ga_job_wake(impl, ready_count);
+	}
+
+	while (continuations)
+	{
+		ga_job_counter* next = continuations->_next_continuation;
+		_ga_job_push(impl, continuations->_continuation_decls, continuations->_continuation_decl_count, continuations);
+		continuations = next;
+	}
+}
+
+static int32_t _ga_job_counter_lock(ga_job_counter* counter)
+{
+	int32_t count = counter->_count.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		if (count & k_ga_job_counter_lock)
+		{
+			count = counter->_count.load(std::memory_order_relaxed);
+		}
+		else if (counter->_count.compare_exchange_weak(count, count | k_ga_job_counter_lock, std::memory_order_acquire))
+		{
+			return count;
+		}
+	}
+}
+
+static void _ga_job_counter_unlock(ga_job_counter* counter)
+{
+	counter->_count.fetch_and(~k_ga_job_counter_lock, std::memory_order_release);
+}
+
+static void _ga_job_wake(ga_job_system_impl_t* impl, int count)
+{
+	/* Prefer sleeping workers. The main thread picks up what's left over. */
+	if (impl->_work_available.notify(count) < count)
+	{
+		impl->_main_wake.notify(1);
+	}
+}
+
+static void _ga_job_parallel_for_worker(void* data)
+{
+	ga_job_parallel_for_range_t* range = static_cast<ga_job_parallel_for_range_t*>(data);
+	ga_job_parallel_for_t* loop = range->_loop;
+
+	int begin = range->_begin;
+	int end = range->_end;
+	while (begin < end)
+	{
+		/*
+		** Between chunks, hand the back half of what's left to whoever is
+		** idle. A range that turns out to be expensive keeps getting split.
+		*/
+		if (end - begin >= 2 * loop->_grain && _ga_job_parallel_for_should_split(loop->_impl, loop->_priority))
+		{
+			int index = loop->_job_count.fetch_add(1);
+			if (index < k_ga_job_parallel_for_max_jobs)
+			{
+				int middle = begin + (end - begin) / 2;
+
+				loop->_ranges[index]._loop = loop;
+				loop->_ranges[index]._begin = middle;
+				loop->_ranges[index]._end = end;
+				loop->_decls[index]._entry = _ga_job_parallel_for_worker;
+				loop->_decls[index]._data = &loop->_ranges[index];
+				loop->_decls[index]._priority = loop->_priority;
+				loop->_decls[index]._stack = loop->_stack;
+				ga_job::run(&loop->_decls[index], 1, &loop->_counter);
+
+				end = middle;
+			}
+		}
+
+		int chunk_end = end - begin > loop->_grain ? begin + loop->_grain : end;
+		loop->_func(begin, chunk_end, loop->_data);
+		begin = chunk_end;
+	}
+}
+
+static bool _ga_job_parallel_for_should_split(ga_job_system_impl_t* impl, int priority)
+{
+	/* Someone is asleep, or nothing is left in our deque for thieves. */
+	if (impl->_work_available.get_waiter_count() > 0)
+	{
+		return true;
+	}
+	int worker_index = _ga_job_worker_index;
+	return worker_index >= 0 && impl->_worker_deques[priority][worker_index]->get_count() == 0;
+}
+
+static void _ga_job_fiber_worker(void*)
 {
 	for (;;)
 	{
@@ -231,3 +1128,8 @@ static void _ga_job_fiber_worker(void* data)
 		ga_fiber::switch_to(*job->_parent_fiber);
 	}
 }
+
+int32_t ga_job_counter::get_count() const
+{
+	return _count.load() & ~k_ga_job_counter_lock;
+}
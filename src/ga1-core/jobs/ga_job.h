@@ -11,13 +11,52 @@
 ** Based on: "Parallelizing the Naughty Dog Engine Using Fibers", Christian Gyrling
 */
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <vector>
+
+struct ga_job_counter;
 
 /*
 ** Job entry point.
 */
 typedef void(*ga_job_function_t)(void* data);
 
+/*
+** Loop body for ga_job::parallel_for. Handles indices [begin, end).
+*/
+typedef void(*ga_job_range_function_t)(int begin, int end, void* data);
+
+/*
+** Job priorities. Workers always take the highest priority job available.
+** Critical is for work the current frame is waiting on; background is for
+** work with no deadline, such as streaming, and is held to a per-frame
+** time budget.
+*/
+enum ga_job_priority_t
+{
+	k_job_priority_critical,
+	k_job_priority_normal,
+	k_job_priority_background,
+
+	k_job_priority_count,
+};
+
+/*
+** Fiber stack a job runs on. Most jobs fit in a small stack; jobs with deep
+** call chains or big locals should ask for a large one. Large stacks are
+** fewer, so prefer small.
+*/
+enum ga_job_stack_t
+{
+	k_job_stack_small,
+	k_job_stack_large,
+
+	k_job_stack_count,
+};
+
 /*
 ** Defines a job.
 */
@@ -26,7 +65,81 @@ struct ga_job_decl_t
 	ga_job_function_t _entry;
 	void* _data;
 
-	int32_t* _pending_count;
+	ga_job_priority_t _priority = k_job_priority_normal;
+	ga_job_stack_t _stack = k_job_stack_small;
+
+	ga_job_counter* _pending_count;
+};
+
+/*
+** Counts a group of outstanding jobs. Jobs can wait on it, and continuation
+** jobs can be attached to run once it reaches zero.
+**
+** Counters are padded to a cache line so that neighboring counters, e.g. in
+** an array of per-stage counters, don't slow each other down.
+*/
+struct alignas(64) ga_job_counter
+{
+	ga_job_counter() :
+		_count(0),
+		_waiters(0),
+		_continuations(0),
+		_next_continuation(0),
+		_continuation_decls(0),
+		_continuation_decl_count(0)
+	{}
+
+	int32_t get_count() const;
+
+	/*
+	** Pending job count. The top bit locks the lists below; the decrement to
+	** zero takes the lock, so once a zero count is visible nobody touches the
+	** counter again and it may safely go out of scope.
+	*/
+	std::atomic<int32_t> _count;
+
+	/* Jobs suspended in wait() on this counter. */
+	struct ga_job_instance_t* _waiters;
+
+	/* Counters whose continuation jobs start when this one reaches zero. */
+	ga_job_counter* _continuations;
+	ga_job_counter* _next_continuation;
+
+	/* Jobs this counter tracks that are held until a prior counter is done. */
+	ga_job_decl_t* _continuation_decls;
+	int _continuation_decl_count;
+};
+
+/*
+** How often the job system ran out of room and had to back off.
+** Either one going up means the pools or queues are too small.
+*/
+struct ga_job_stats
+{
+	/* A job had to wait for a fiber of its stack size to free up. */
+	uint64_t _fiber_pool_exhausted;
+
+	/* A shared queue was full, so a job ran on its submitter or went on a fallback list. */
+	uint64_t _queue_full;
+};
+
+/*
+** Job system setup.
+*/
+struct ga_job_config
+{
+	/*
+	** Logical CPU ids, from ga_cpu_topology, to run a worker on each.
+	** Empty means one worker per logical CPU available to the process.
+	*/
+	std::vector<int> _worker_cpus;
+
+	/* Pin each worker to its CPU. */
+	bool _pin_workers = false;
+
+	int _queue_size = 256;
+	int _fiber_count = 256;
+	int _large_fiber_count = 16;
 };
 
 /*
@@ -35,16 +148,87 @@ struct ga_job_decl_t
 class ga_job
 {
 public:
+	static void startup(const ga_job_config& config);
+
+	/* Runs a worker for each set bit, among the first 32 logical CPUs. */
 	static void startup(
 		uint32_t hardware_thread_mask,
 		int queue_size,
-		int fiber_count);
+		int fiber_count,
+		int large_fiber_count = 16);
 
 	static void shutdown();
 
-	static void run(ga_job_decl_t* decls, int decl_count, int32_t* counter);
+	/* Queues jobs and adds them to the counter. */
+	static void run(ga_job_decl_t* decls, int decl_count, ga_job_counter* counter);
+
+	/*
+	** Queues jobs once counter reaches zero, or right away if it already has.
+	** The jobs are added to continuation_counter immediately, so waiting on it
+	** covers both. decls must stay valid until the jobs run, and
+	** continuation_counter can only hold one pending continuation at a time.
+	*/
+	static void run_after(
+		ga_job_counter* counter,
+		ga_job_decl_t* decls,
+		int decl_count,
+		ga_job_counter* continuation_counter);
+
+	static void wait(ga_job_counter* counter);
+
+	/*
+	** Holds a counter open for work done outside the job system, like I/O.
+	** Each add must be matched by a complete, which may come from any
+	** thread. A job waiting on the counter stays suspended until then.
+	*/
+	static void add_external(ga_job_counter* counter, int count);
+	static void complete_external(ga_job_counter* counter);
+
+	/*
+	** Starts a new frame's background budget. Background jobs only start
+	** while the budget lasts, though at least one starts every frame, and
+	** the main thread never runs them. Unlimited until a budget is set.
+	*/
+	static void begin_frame();
+	static void set_background_budget(std::chrono::microseconds budget);
+
+	/*
+	** Scratch memory from a linear allocator owned by the calling thread.
+	** Only for jobs and the main thread. Nothing is freed individually; it
+	** all stays valid until the next begin_frame, so background jobs that
+	** run past their frame must not hold on to it.
+	*/
+	static void* alloc_scratch(size_t size, size_t alignment = 16);
+
+	template<class T>
+	static T* alloc_scratch_array(int count)
+	{
+		return static_cast<T*>(alloc_scratch(count * sizeof(T), alignof(T)));
+	}
+
+	/*
+	** Index of the calling thread among the workers and the main thread, in
+	** [0, get_thread_count()). Only for jobs and the main thread, and only
+	** good until the job next waits, since it may resume on another thread.
+	** Before startup there's just the one thread.
+	*/
+	static int get_thread_index();
+	static int get_thread_count();
+
+	/*
+	** Whether the calling thread is a worker or the main thread. Any other
+	** thread gets the main thread's index from get_thread_index.
+	*/
+	static bool is_job_thread();
+
+	static ga_job_stats get_stats();
 
-	static void wait(int32_t* counter);
+	/*
+	** Calls func over [begin, end) in chunks of at most grain indices, spread
+	** across the workers, and returns when all are done. The range starts out
+	** split once per worker; a chunk splits again when others run out of work.
+	*/
+	static void parallel_for(int begin, int end, int grain, ga_job_range_function_t func, void* data);
 
 private:
 	static void* _impl;
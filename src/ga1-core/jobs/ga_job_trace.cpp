@@ -0,0 +1,231 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_job_trace.h"
+
+#if GA_JOB_TRACE
+
+#include "framework/ga_compiler_defines.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#if defined(GA_MSVC)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static const int k_ga_job_trace_ring_size = 16 * 1024;
+static const int k_ga_job_trace_frame_history = 64;
+
+struct ga_job_trace_record_t
+{
+	uint64_t _time;
+	const void* _name;
+	const void* _id;
+	ga_job_trace_event_t _type;
+};
+
+struct ga_job_trace_ring_t
+{
+	char _name[32];
+	int _tid;
+
+	/* Total events ever written. Only the owner thread advances it. */
+	std::atomic<uint64_t> _head;
+	ga_job_trace_record_t _records[k_ga_job_trace_ring_size];
+};
+
+static std::mutex _ga_job_trace_mutex;
+static std::vector<ga_job_trace_ring_t*> _ga_job_trace_rings;
+
+static std::atomic<uint64_t> _ga_job_trace_frame_count(0);
+static std::atomic<uint64_t> _ga_job_trace_frames[k_ga_job_trace_frame_history];
+
+static thread_local ga_job_trace_ring_t* _ga_job_trace_ring = 0;
+
+static inline uint64_t _ga_job_trace_now()
+{
+#if defined(GA_MSVC) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+/* Pairs of timestamp and wall clock, to convert ticks to microseconds. */
+static uint64_t _ga_job_trace_start_ticks = _ga_job_trace_now();
+static std::chrono::steady_clock::time_point _ga_job_trace_start_time = std::chrono::steady_clock::now();
+
+void ga_job_trace::register_thread(const char* name)
+{
+	ga_job_trace_ring_t* ring = new ga_job_trace_ring_t;
+	strncpy(ring->_name, name, sizeof(ring->_name) - 1);
+	ring->_name[sizeof(ring->_name) - 1] = 0;
+	ring->_head = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(_ga_job_trace_mutex);
+		ring->_tid = int(_ga_job_trace_rings.size());
+		_ga_job_trace_rings.push_back(ring);
+	}
+
+	_ga_job_trace_ring = ring;
+}
+
+void ga_job_trace::record(ga_job_trace_event_t type, const void* name, const void* id)
+{
+	uint64_t now = _ga_job_trace_now();
+
+	if (type == k_job_trace_frame)
+	{
+		uint64_t frame = _ga_job_trace_frame_count.load(std::memory_order_relaxed);
+		_ga_job_trace_frames[frame % k_ga_job_trace_frame_history].store(now, std::memory_order_relaxed);
+		_ga_job_trace_frame_count.store(frame + 1, std::memory_order_release);
+	}
+
+	ga_job_trace_ring_t* ring = _ga_job_trace_ring;
+	if (!ring)
+	{
+		return;
+	}
+
+	uint64_t head = ring->_head.load(std::memory_order_relaxed);
+	ga_job_trace_record_t& r = ring->_records[head % k_ga_job_trace_ring_size];
+	r._time = now;
+	r._name = name;
+	r._id = id;
+	r._type = type;
+	ring->_head.store(head + 1, std::memory_order_release);
+}
+
+bool ga_job_trace::dump(const char* path, int frame_count)
+{
+	FILE* file = fopen(path, "w");
+	if (!file)
+	{
+		return false;
+	}
+
+	/* Ticks per microsecond, measured over the whole run so far. */
+	uint64_t end_ticks = _ga_job_trace_now();
+	double elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _ga_job_trace_start_time).count();
+	double ticks_per_us = elapsed_us > 0.0 ? double(end_ticks - _ga_job_trace_start_ticks) / elapsed_us : 1.0;
+
+	/* The window opens at the start of the frame_count'th most recent frame. */
+	uint64_t frames = _ga_job_trace_frame_count.load(std::memory_order_acquire);
+	uint64_t window_start = 0;
+	if (frame_count > k_ga_job_trace_frame_history)
+	{
+		frame_count = k_ga_job_trace_frame_history;
+	}
+	if (frame_count > 0 && frames >= uint64_t(frame_count))
+	{
+		window_start = _ga_job_trace_frames[(frames - frame_count) % k_ga_job_trace_frame_history].load();
+	}
+
+	static const char* k_names[] = { "job", "job", "suspend", "resume", "steal", "park", "unpark", "frame" };
+
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	bool first = true;
+
+	std::lock_guard<std::mutex> lock(_ga_job_trace_mutex);
+	for (auto ring : _ga_job_trace_rings)
+	{
+		fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+			first ? "" : ",\n", ring->_tid, ring->_name);
+		first = false;
+
+		uint64_t head = ring->_head.load(std::memory_order_acquire);
+		uint64_t tail = head > k_ga_job_trace_ring_size ? head - k_ga_job_trace_ring_size : 0;
+
+		/* Skip the end of a slice whose begin fell outside the window. */
+		bool in_slice = false;
+
+		for (uint64_t i = tail; i < head; ++i)
+		{
+			ga_job_trace_record_t r = ring->_records[i % k_ga_job_trace_ring_size];
+			if (r._time < window_start || r._time < _ga_job_trace_start_ticks)
+			{
+				continue;
+			}
+
+			double ts = double(r._time - _ga_job_trace_start_ticks) / ticks_per_us;
+			char name[32];
+			snprintf(name, sizeof(name), "%s %p", k_names[r._type], r._name);
+
+			switch (r._type)
+			{
+			case k_job_trace_begin:
+			case k_job_trace_resume:
+				fprintf(file, ",\n{\"ph\":\"B\",\"name\":\"%s\",\"pid\":0,\"tid\":%d,\"ts\":%.3f}", name, ring->_tid, ts);
+				if (r._type == k_job_trace_resume)
+				{
+					fprintf(file, ",\n{\"ph\":\"e\",\"cat\":\"suspended\",\"name\":\"suspended\",\"id\":\"%p\",\"pid\":0,\"tid\":%d,\"ts\":%.3f}", r._id, ring->_tid, ts);
+				}
+				in_slice = true;
+				break;
+			case k_job_trace_end:
+			case k_job_trace_suspend:
+				if (in_slice)
+				{
+					fprintf(file, ",\n{\"ph\":\"E\",\"pid\":0,\"tid\":%d,\"ts\":%.3f}", ring->_tid, ts);
+				}
+				if (r._type == k_job_trace_suspend)
+				{
+					fprintf(file, ",\n{\"ph\":\"b\",\"cat\":\"suspended\",\"name\":\"suspended\",\"id\":\"%p\",\"pid\":0,\"tid\":%d,\"ts\":%.3f}", r._id, ring->_tid, ts);
+				}
+				in_slice = false;
+				break;
+			case k_job_trace_park:
+				fprintf(file, ",\n{\"ph\":\"B\",\"name\":\"park\",\"pid\":0,\"tid\":%d,\"ts\":%.3f}", ring->_tid, ts);
+				in_slice = true;
+				break;
+			case k_job_trace_unpark:
+				if (in_slice)
+				{
+					fprintf(file, ",\n{\"ph\":\"E\",\"pid\":0,\"tid\":%d,\"ts\":%.3f}", ring->_tid, ts);
+				}
+				in_slice = false;
+				break;
+			case k_job_trace_steal:
+			case k_job_trace_frame:
+				fprintf(file, ",\n{\"ph\":\"i\",\"s\":\"%s\",\"name\":\"%s\",\"pid\":0,\"tid\":%d,\"ts\":%.3f}",
+					r._type == k_job_trace_frame ? "g" : "t", k_names[r._type], ring->_tid, ts);
+				break;
+			}
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	return true;
+}
+
+#else
+
+void ga_job_trace::register_thread(const char*)
+{
+}
+
+void ga_job_trace::record(ga_job_trace_event_t, const void*, const void*)
+{
+}
+
+bool ga_job_trace::dump(const char*, int)
+{
+	return false;
+}
+
+#endif
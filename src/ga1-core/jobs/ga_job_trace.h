@@ -0,0 +1,64 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include <cstdint>
+
+/*
+** Set to 1 to record job system events. When 0 the recording macros
+** expand to nothing and dump() writes nothing.
+*/
+#if !defined(GA_JOB_TRACE)
+#define GA_JOB_TRACE 0
+#endif
+
+enum ga_job_trace_event_t
+{
+	k_job_trace_begin,
+	k_job_trace_end,
+	k_job_trace_suspend,
+	k_job_trace_resume,
+	k_job_trace_steal,
+	k_job_trace_park,
+	k_job_trace_unpark,
+	k_job_trace_frame,
+};
+
+/*
+** Records job system events into a ring buffer per thread, stamped with
+** the CPU timestamp counter, and writes them out as Chrome trace_event
+** JSON for chrome://tracing or Perfetto.
+**
+** Only the owning thread writes a ring, so recording is a few stores.
+** Old events are overwritten once a ring wraps.
+*/
+class ga_job_trace
+{
+public:
+	/* Gives the calling thread a ring. Threads without one record nothing. */
+	static void register_thread(const char* name);
+
+	/*
+	** name identifies the job, e.g. its entry point; id ties a job's
+	** suspend to its resume.
+	*/
+	static void record(ga_job_trace_event_t type, const void* name, const void* id);
+
+	/* Writes events from the last frame_count frames. Returns false on failure. */
+	static bool dump(const char* path, int frame_count);
+};
+
+#if GA_JOB_TRACE
+#define GA_JOB_TRACE_THREAD(name) ga_job_trace::register_thread(name)
+#define GA_JOB_TRACE_EVENT(type, name, id) ga_job_trace::record(type, name, id)
+#else
+#define GA_JOB_TRACE_THREAD(name) ((void)0)
+#define GA_JOB_TRACE_EVENT(type, name, id) ((void)0)
+#endif
@@ -0,0 +1,645 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+/*
+** Randomized stress test for the lock-free containers and the job system.
+** Checks that nothing is lost, duplicated, or reordered per producer, that
+** pool indices are never handed out twice, and that the job system gets
+** through random job trees even with tiny fiber pools and queues. Reports
+** throughput and operation latency percentiles per thread count.
+**
+** Usage: ga_jobs_stress [seed]. Returns nonzero on the first failure.
+*/
+
+#include "ga_intpool.h"
+#include "ga_job.h"
+#include "ga_mpmc_queue.h"
+#include "ga_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock ga_stress_clock_t;
+
+static const int k_items_per_producer = 1 << 16;
+static const int k_queue_size = 1024;
+static const int k_max_batch = 16;
+
+/* Record the latency of every n'th operation. */
+static const int k_latency_sample_rate = 16;
+
+static uint32_t g_seed = 1;
+static std::atomic<int> g_failures(0);
+
+#define STRESS_CHECK(cond, ...) \
+	do { if (!(cond)) { g_failures++; printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+/* xorshift32, so every thread has its own cheap stream. */
+struct stress_random_t
+{
+	uint32_t _state;
+
+	stress_random_t(uint32_t seed) : _state(seed * 2654435761u + 1) {}
+
+	uint32_t next()
+	{
+		_state ^= _state << 13;
+		_state ^= _state >> 17;
+		_state ^= _state << 5;
+		return _state;
+	}
+
+	int range(int n) { return int(next() % uint32_t(n)); }
+};
+
+struct stress_latency_t
+{
+	std::vector<uint32_t> _samples;
+
+	void merge(const stress_latency_t& other)
+	{
+		_samples.insert(_samples.end(), other._samples.begin(), other._samples.end());
+	}
+
+	void print(const char* name, int threads, uint64_t ops, double seconds)
+	{
+		std::sort(_samples.begin(), _samples.end());
+		auto at = [&](double p) -> uint32_t
+		{
+			if (_samples.empty()) return 0;
+			return _samples[std::min(_samples.size() - 1, size_t(p * _samples.size()))];
+		};
+		printf("%-16s %4d %10.2f Mop/s   p50 %6u  p99 %6u  p999 %7u  max %8u ns\n",
+			name, threads, ops / seconds / 1e6, at(0.5), at(0.99), at(0.999),
+			_samples.empty() ? 0 : _samples.back());
+	}
+};
+
+template<class T>
+static double run_threads(int thread_count, T func)
+{
+	std::atomic<int> ready(0);
+	std::atomic<bool> go(false);
+	std::vector<std::thread> threads;
+
+	for (int t = 0; t < thread_count; ++t)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			ready++;
+			while (!go) {}
+			func(t);
+		}));
+	}
+
+	while (ready < thread_count) {}
+	auto t0 = ga_stress_clock_t::now();
+	go = true;
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+	return std::chrono::duration<double>(ga_stress_clock_t::now() - t0).count();
+}
+
+/*
+** Items carry their producer in the high bits and a 1-based sequence in the
+** low bits, so a consumer can check each producer's items arrive in order.
+*/
+static inline void* make_item(int producer, int sequence)
+{
+	return reinterpret_cast<void*>((uintptr_t(producer) << 32) | uintptr_t(sequence + 1));
+}
+
+/* Wraps a container so the MPMC test can drive either with batches. */
+struct stress_ga_queue_t
+{
+	ga_queue _queue;
+	stress_ga_queue_t() : _queue(k_queue_size) {}
+
+	int push_n(void* const* data, int count) { return _queue.push(data[0]) ? 1 : 0; }
+	int pop_n(void** data, int count) { return _queue.pop(data) ? 1 : 0; }
+};
+
+struct stress_mpmc_queue_t
+{
+	ga_mpmc_queue _queue;
+	stress_mpmc_queue_t() : _queue(k_queue_size) {}
+
+	int push_n(void* const* data, int count) { return _queue.push_n(data, count); }
+	int pop_n(void** data, int count) { return _queue.pop_n(data, count); }
+};
+
+template<class T>
+static void stress_queue(const char* name, int producer_count, int consumer_count)
+{
+	T queue;
+	std::atomic<int> producers_done(0);
+	std::unique_ptr<std::atomic<uint8_t>[]> seen(new std::atomic<uint8_t>[size_t(producer_count) * k_items_per_producer]);
+	for (int i = 0; i < producer_count * k_items_per_producer; ++i)
+	{
+		seen[i] = 0;
+	}
+
+	std::vector<stress_latency_t> latency(producer_count + consumer_count);
+
+	double seconds = run_threads(producer_count + consumer_count, [&](int t)
+	{
+		stress_random_t random(g_seed + t);
+		void* batch[k_max_batch];
+		int op = 0;
+
+		if (t < producer_count)
+		{
+			for (int sequence = 0; sequence < k_items_per_producer; )
+			{
+				int count = std::min(1 + random.range(k_max_batch), k_items_per_producer - sequence);
+				for (int i = 0; i < count; ++i)
+				{
+					batch[i] = make_item(t, sequence + i);
+				}
+
+				for (int pushed = 0; pushed < count; )
+				{
+					auto t0 = ga_stress_clock_t::now();
+					int n = queue.push_n(batch + pushed, count - pushed);
+					if ((op++ % k_latency_sample_rate) == 0)
+					{
+						latency[t]._samples.push_back(uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(ga_stress_clock_t::now() - t0).count()));
+					}
+					if (n == 0)
+					{
+						std::this_thread::yield();
+					}
+					pushed += n;
+				}
+				sequence += count;
+			}
+			producers_done++;
+			return;
+		}
+
+		/* Last sequence seen from each producer, to check order. */
+		std::vector<int> last(producer_count, 0);
+		for (;;)
+		{
+			bool done = producers_done == producer_count;
+
+			auto t0 = ga_stress_clock_t::now();
+			int n = queue.pop_n(batch, 1 + random.range(k_max_batch));
+			if (n > 0 && (op++ % k_latency_sample_rate) == 0)
+			{
+				latency[t]._samples.push_back(uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(ga_stress_clock_t::now() - t0).count()));
+			}
+
+			if (n == 0)
+			{
+				if (done)
+				{
+					break;
+				}
+				std::this_thread::yield();
+				continue;
+			}
+
+			for (int i = 0; i < n; ++i)
+			{
+				uintptr_t item = reinterpret_cast<uintptr_t>(batch[i]);
+				int producer = int(item >> 32);
+				int sequence = int(item & 0xffffffff);
+
+				STRESS_CHECK(producer < producer_count && sequence >= 1 && sequence <= k_items_per_producer,
+					"%s: garbage item %p", name, batch[i]);
+				if (producer >= producer_count || sequence < 1 || sequence > k_items_per_producer)
+				{
+					continue;
+				}
+				STRESS_CHECK(sequence > last[producer], "%s: producer %d item %d after %d", name, producer, sequence, last[producer]);
+				last[producer] = sequence;
+
+				uint8_t count = seen[size_t(producer) * k_items_per_producer + sequence - 1]++;
+				STRESS_CHECK(count == 0, "%s: duplicate of producer %d item %d", name, producer, sequence);
+			}
+		}
+	});
+
+	int lost = 0;
+	for (int i = 0; i < producer_count * k_items_per_producer; ++i)
+	{
+		lost += seen[i] == 0;
+	}
+	STRESS_CHECK(lost == 0, "%s: %d items lost", name, lost);
+
+	stress_latency_t all;
+	for (auto& l : latency)
+	{
+		all.merge(l);
+	}
+	all.print(name, producer_count + consumer_count, 2ull * producer_count * k_items_per_producer, seconds);
+}
+
+static void stress_intpool(int thread_count)
+{
+	const int k_index_count = 64;
+	const int k_ops_per_thread = 1 << 17;
+
+	/* A full pool reports -1 and recovers once an index comes back. */
+	{
+		ga_intpool pool(k_index_count);
+		std::vector<int> indices;
+		for (int i = 0; i < k_index_count; ++i)
+		{
+			indices.push_back(pool.alloc());
+			STRESS_CHECK(indices.back() >= 0, "intpool: ran out after %d", i);
+		}
+		STRESS_CHECK(pool.alloc() == -1, "intpool: alloc past capacity");
+		pool.free(indices[0]);
+		STRESS_CHECK(pool.alloc() == indices[0], "intpool: freed index not reused");
+	}
+
+	ga_intpool pool(k_index_count);
+	std::unique_ptr<std::atomic<int>[]> owner(new std::atomic<int>[k_index_count]);
+	for (int i = 0; i < k_index_count; ++i)
+	{
+		owner[i] = -1;
+	}
+
+	std::vector<stress_latency_t> latency(thread_count);
+
+	double seconds = run_threads(thread_count, [&](int t)
+	{
+		stress_random_t random(g_seed + t);
+		std::vector<int> held;
+
+		for (int op = 0; op < k_ops_per_thread; ++op)
+		{
+			if (held.empty() || (held.size() < 8 && random.range(2) == 0))
+			{
+				auto t0 = ga_stress_clock_t::now();
+				int index = pool.alloc();
+				if ((op % k_latency_sample_rate) == 0)
+				{
+					latency[t]._samples.push_back(uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(ga_stress_clock_t::now() - t0).count()));
+				}
+				if (index < 0)
+				{
+					continue;
+				}
+
+				int expected = -1;
+				STRESS_CHECK(index < k_index_count && owner[index].compare_exchange_strong(expected, t),
+					"intpool: index %d handed to %d while owned by %d", index, t, expected);
+				held.push_back(index);
+			}
+			else
+			{
+				int slot = random.range(int(held.size()));
+				int index = held[slot];
+				held[slot] = held.back();
+				held.pop_back();
+
+				owner[index] = -1;
+				pool.free(index);
+			}
+		}
+
+		for (int index : held)
+		{
+			owner[index] = -1;
+			pool.free(index);
+		}
+	});
+
+	stress_latency_t all;
+	for (auto& l : latency)
+	{
+		all.merge(l);
+	}
+	all.print("ga_intpool", thread_count, uint64_t(thread_count) * k_ops_per_thread, seconds);
+}
+
+/*
+** Random job trees. Each node's shape comes from its seed alone, so the
+** expected node count can be worked out serially up front.
+*/
+static std::atomic<uint64_t> g_tree_nodes(0);
+static std::atomic<uint64_t> g_tree_items(0);
+
+static const int k_tree_max_children = 6;
+static const int k_tree_parallel_for_count = 200;
+
+struct stress_tree_shape_t
+{
+	int _children;
+	bool _parallel_for;
+	bool _continuation;
+};
+
+static stress_tree_shape_t tree_shape(uint32_t seed, int depth)
+{
+	stress_random_t random(seed);
+	stress_tree_shape_t shape;
+	shape._children = depth > 0 ? random.range(k_tree_max_children + 1) : 0;
+	shape._parallel_for = random.range(4) == 0;
+	shape._continuation = shape._children > 0 && random.range(3) == 0;
+	return shape;
+}
+
+static uint64_t tree_expected_nodes(uint32_t seed, int depth, uint64_t* items)
+{
+	stress_tree_shape_t shape = tree_shape(seed, depth);
+	uint64_t nodes = 1 + (shape._continuation ? 1 : 0);
+	*items += shape._parallel_for ? k_tree_parallel_for_count : 0;
+	for (int i = 0; i < shape._children; ++i)
+	{
+		nodes += tree_expected_nodes(seed * 31 + i + 1, depth - 1, items);
+	}
+	return nodes;
+}
+
+struct stress_tree_node_t
+{
+	uint32_t _seed;
+	int _depth;
+};
+
+static void tree_count_range(int begin, int end, void* data)
+{
+	g_tree_items += end - begin;
+}
+
+static void tree_continuation(void* data)
+{
+	g_tree_nodes++;
+}
+
+static void tree_node(void* data)
+{
+	stress_tree_node_t* node = static_cast<stress_tree_node_t*>(data);
+	stress_tree_shape_t shape = tree_shape(node->_seed, node->_depth);
+	stress_random_t random(node->_seed ^ 0x9e3779b9);
+
+	g_tree_nodes++;
+
+	if (shape._parallel_for)
+	{
+		ga_job::parallel_for(0, k_tree_parallel_for_count, 1 + random.range(16), tree_count_range, 0);
+	}
+
+	stress_tree_node_t children[k_tree_max_children];
+	ga_job_decl_t decls[k_tree_max_children];
+	for (int i = 0; i < shape._children; ++i)
+	{
+		children[i]._seed = node->_seed * 31 + i + 1;
+		children[i]._depth = node->_depth - 1;
+		decls[i]._entry = tree_node;
+		decls[i]._data = &children[i];
+		decls[i]._priority = ga_job_priority_t(random.range(k_job_priority_count));
+		decls[i]._stack = random.range(8) == 0 ? k_job_stack_large : k_job_stack_small;
+	}
+
+	ga_job_counter counter;
+	ga_job::run(decls, shape._children, &counter);
+
+	if (shape._continuation)
+	{
+		ga_job_decl_t continuation;
+		continuation._entry = tree_continuation;
+		continuation._data = 0;
+
+		ga_job_counter continuation_counter;
+		ga_job::run_after(&counter, &continuation, 1, &continuation_counter);
+		ga_job::wait(&continuation_counter);
+	}
+	ga_job::wait(&counter);
+}
+
+/*
+** Every node that waits holds a fiber, so the pools are sized for the
+** biggest tree that can be in flight at once. Anything less can deadlock.
+*/
+static void stress_job_tree(const char* name, int trees, int depth)
+{
+	g_tree_nodes = 0;
+	g_tree_items = 0;
+
+	uint64_t expected_items = 0;
+	uint64_t expected_nodes = 0;
+	std::vector<stress_tree_node_t> roots(trees);
+	std::vector<ga_job_decl_t> decls(trees);
+	for (int i = 0; i < trees; ++i)
+	{
+		roots[i]._seed = g_seed * 7919 + i;
+		roots[i]._depth = depth;
+		decls[i]._entry = tree_node;
+		decls[i]._data = &roots[i];
+		expected_nodes += tree_expected_nodes(roots[i]._seed, depth, &expected_items);
+	}
+
+	auto t0 = ga_stress_clock_t::now();
+	ga_job_counter counter;
+	ga_job::run(decls.data(), trees, &counter);
+	ga_job::wait(&counter);
+	double seconds = std::chrono::duration<double>(ga_stress_clock_t::now() - t0).count();
+
+	STRESS_CHECK(g_tree_nodes == expected_nodes, "%s: ran %llu nodes, expected %llu",
+		name, (unsigned long long)g_tree_nodes.load(), (unsigned long long)expected_nodes);
+	STRESS_CHECK(g_tree_items == expected_items, "%s: covered %llu items, expected %llu",
+		name, (unsigned long long)g_tree_items.load(), (unsigned long long)expected_items);
+
+	ga_job_stats stats = ga_job::get_stats();
+	printf("%-16s %llu jobs in %.1f ms, fiber pool exhausted %llu, queue full %llu\n",
+		name, (unsigned long long)expected_nodes, seconds * 1e3,
+		(unsigned long long)stats._fiber_pool_exhausted, (unsigned long long)stats._queue_full);
+}
+
+/* Sleeps so jobs pile up on the fibers while the submitter keeps going. */
+static void stress_leaf(void* data)
+{
+	std::this_thread::sleep_for(std::chrono::microseconds(20));
+	g_tree_nodes++;
+}
+
+/*
+** A wide fan-out from the main thread against a handful of fibers and a
+** tiny queue. Has to finish, and has to say it ran out of room.
+*/
+static void stress_job_exhaustion(int job_count)
+{
+	g_tree_nodes = 0;
+
+	std::vector<ga_job_decl_t> decls(job_count);
+	for (auto& d : decls)
+	{
+		d._entry = stress_leaf;
+		d._data = 0;
+		d._stack = (&d - decls.data()) % 8 == 0 ? k_job_stack_large : k_job_stack_small;
+	}
+
+	ga_job_counter counter;
+	ga_job::run(decls.data(), job_count, &counter);
+	ga_job::wait(&counter);
+
+	ga_job_stats stats = ga_job::get_stats();
+	STRESS_CHECK(g_tree_nodes == uint64_t(job_count), "exhaustion: ran %llu of %d jobs",
+		(unsigned long long)g_tree_nodes.load(), job_count);
+	STRESS_CHECK(stats._queue_full > 0, "exhaustion: full queue went unreported");
+	printf("%-16s %d jobs, fiber pool exhausted %llu, queue full %llu\n", "exhaustion", job_count,
+		(unsigned long long)stats._fiber_pool_exhausted, (unsigned long long)stats._queue_full);
+}
+
+/* Fans out to a few leaves, one wanting a large stack, and waits on them. */
+static void stress_fan_out(void* data)
+{
+	ga_job_decl_t decls[4];
+	for (auto& d : decls)
+	{
+		d._entry = stress_leaf;
+		d._data = 0;
+	}
+	decls[0]._stack = k_job_stack_large;
+
+	ga_job_counter counter;
+	ga_job::run(decls, 4, &counter);
+	ga_job::wait(&counter);
+}
+
+/*
+** Continuations that wait, queued by the scheduler into a full queue while
+** the main thread waits on them. Has to finish.
+*/
+static void stress_job_continuations(int chain_count)
+{
+	g_tree_nodes = 0;
+
+	std::vector<ga_job_decl_t> heads(chain_count);
+	std::vector<ga_job_decl_t> tails(chain_count);
+	std::vector<ga_job_counter> head_counters(chain_count);
+	std::vector<ga_job_counter> tail_counters(chain_count);
+	for (int i = 0; i < chain_count; ++i)
+	{
+		heads[i]._entry = stress_leaf;
+		heads[i]._data = 0;
+		tails[i]._entry = stress_fan_out;
+		tails[i]._data = 0;
+
+		ga_job::run(&heads[i], 1, &head_counters[i]);
+		ga_job::run_after(&head_counters[i], &tails[i], 1, &tail_counters[i]);
+	}
+	for (int i = 0; i < chain_count; ++i)
+	{
+		ga_job::wait(&tail_counters[i]);
+	}
+
+	STRESS_CHECK(g_tree_nodes == uint64_t(chain_count) * 5, "continuations: ran %llu of %d jobs",
+		(unsigned long long)g_tree_nodes.load(), chain_count * 5);
+	printf("%-16s %d chains\n", "continuations", chain_count);
+}
+
+/*
+** Scratch memory from every thread across a few frames. Each thread's
+** arena has to rewind on its first use after begin_frame, and never hand
+** out memory another job is still using.
+*/
+static void stress_job_scratch(int frame_count)
+{
+	void* first = ga_job::alloc_scratch(64);
+	void* second = ga_job::alloc_scratch(64);
+	STRESS_CHECK(first != second, "scratch: same block handed out twice");
+
+	for (int frame = 0; frame < frame_count; ++frame)
+	{
+		ga_job::begin_frame();
+		void* rewound = ga_job::alloc_scratch(64);
+		STRESS_CHECK(rewound == first, "scratch: frame %d didn't rewind", frame);
+
+		ga_job::parallel_for(0, 4096, 16, [](int begin, int end, void* data)
+		{
+			int* values = ga_job::alloc_scratch_array<int>(end - begin);
+			for (int i = begin; i < end; ++i)
+			{
+				values[i - begin] = i;
+			}
+			std::this_thread::yield();
+			for (int i = begin; i < end; ++i)
+			{
+				STRESS_CHECK(values[i - begin] == i, "scratch: value %d overwritten", i);
+			}
+		}, 0);
+	}
+	printf("%-16s %d frames\n", "scratch", frame_count);
+}
+
+int main(int argc, const char** argv)
+{
+	if (argc > 1)
+	{
+		g_seed = uint32_t(strtoul(argv[1], 0, 0));
+	}
+	printf("seed %u\n", g_seed);
+
+	for (int threads = 2; threads <= 64; threads *= 2)
+	{
+		stress_queue<stress_ga_queue_t>("ga_queue", threads / 2, threads / 2);
+		stress_queue<stress_mpmc_queue_t>("ga_mpmc_queue", threads / 2, threads / 2);
+		stress_intpool(threads);
+	}
+
+	{
+		ga_job_config config;
+		config._fiber_count = 16384;
+		config._large_fiber_count = 4096;
+		ga_job::startup(config);
+		for (int round = 0; round < 8; ++round)
+		{
+			g_seed += round;
+			stress_job_tree("job trees", 8, 4);
+		}
+		ga_job::shutdown();
+	}
+
+	{
+		/* More workers than fibers, and a queue far smaller than the fan-out. */
+		ga_job_config config;
+		config._worker_cpus.assign(8, 0);
+		config._queue_size = 8;
+		config._fiber_count = 4;
+		config._large_fiber_count = 1;
+		ga_job::startup(config);
+		stress_job_exhaustion(4000);
+		ga_job::shutdown();
+	}
+
+	{
+		/* Enough fibers for every waiting job, but still a tiny queue. */
+		ga_job_config config;
+		config._worker_cpus.assign(8, 0);
+		config._queue_size = 8;
+		config._fiber_count = 4096;
+		ga_job::startup(config);
+		stress_job_continuations(500);
+		stress_job_scratch(64);
+		ga_job::shutdown();
+	}
+
+	if (g_failures)
+	{
+		printf("%d failures\n", g_failures.load());
+		return 1;
+	}
+	printf("ok\n");
+	return 0;
+}
@@ -0,0 +1,132 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+/*
+** Contention benchmark for the job queues.
+** Every thread alternates pushes and pops on one shared queue. Reports
+** throughput for ga_queue, ga_mpmc_queue, and ga_mpmc_queue in batches.
+*/
+
+#include "ga_mpmc_queue.h"
+#include "ga_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::high_resolution_clock ga_bench_clock_t;
+
+static const int k_queue_size = 4096;
+static const int k_batch_size = 16;
+
+template<class T>
+static double run_threads(int thread_count, int ops_per_thread, T func)
+{
+	std::atomic<int> ready(0);
+	std::atomic<bool> go(false);
+	std::vector<std::thread> threads;
+
+	for (int t = 0; t < thread_count; ++t)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			ready++;
+			while (!go) {}
+			func(t, ops_per_thread);
+		}));
+	}
+
+	while (ready < thread_count) {}
+	auto t0 = ga_bench_clock_t::now();
+	go = true;
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+	auto t1 = ga_bench_clock_t::now();
+
+	/* Millions of items through the queue per second, pushes and pops. */
+	double seconds = std::chrono::duration<double>(t1 - t0).count();
+	return 2.0 * thread_count * ops_per_thread / seconds / 1e6;
+}
+
+static double bench_ga_queue(int thread_count, int ops_per_thread)
+{
+	ga_queue queue(k_queue_size);
+	return run_threads(thread_count, ops_per_thread, [&](int t, int ops)
+	{
+		void* data;
+		for (int i = 0; i < ops; ++i)
+		{
+			queue.push(reinterpret_cast<void*>(uintptr_t(i + 1)));
+			while (!queue.pop(&data)) {}
+		}
+	});
+}
+
+static double bench_mpmc_queue(int thread_count, int ops_per_thread)
+{
+	ga_mpmc_queue queue(k_queue_size);
+	return run_threads(thread_count, ops_per_thread, [&](int t, int ops)
+	{
+		void* data;
+		for (int i = 0; i < ops; ++i)
+		{
+			while (!queue.push(reinterpret_cast<void*>(uintptr_t(i + 1)))) {}
+			while (!queue.pop(&data)) {}
+		}
+	});
+}
+
+static double bench_mpmc_queue_batch(int thread_count, int ops_per_thread)
+{
+	ga_mpmc_queue queue(k_queue_size);
+	return run_threads(thread_count, ops_per_thread, [&](int t, int ops)
+	{
+		void* batch[k_batch_size];
+		for (int i = 0; i < k_batch_size; ++i)
+		{
+			batch[i] = reinterpret_cast<void*>(uintptr_t(i + 1));
+		}
+
+		for (int i = 0; i < ops; i += k_batch_size)
+		{
+			for (int pushed = 0; pushed < k_batch_size; )
+			{
+				pushed += queue.push_n(batch + pushed, k_batch_size - pushed);
+			}
+			for (int popped = 0; popped < k_batch_size; )
+			{
+				popped += queue.pop_n(batch + popped, k_batch_size - popped);
+			}
+		}
+	});
+}
+
+int main(int argc, const char** argv)
+{
+	const int k_total_ops = 1 << 21;
+
+	printf("%8s %16s %16s %16s\n", "threads", "ga_queue", "ga_mpmc_queue", "mpmc batch 16");
+	for (int threads = 1; threads <= 64; threads *= 2)
+	{
+		int ops = k_total_ops / threads;
+		ops -= ops % k_batch_size;
+
+		double a = bench_ga_queue(threads, ops);
+		double b = bench_mpmc_queue(threads, ops);
+		double c = bench_mpmc_queue_batch(threads, ops);
+		printf("%8d %10.2f Mop/s %10.2f Mop/s %10.2f Mop/s\n", threads, a, b, c);
+	}
+
+	return 0;
+}
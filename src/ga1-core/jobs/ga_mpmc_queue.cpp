@@ -0,0 +1,172 @@
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+#include "ga_mpmc_queue.h"
+
+#include <atomic>
+#include <cstdint>
+
+static const int k_ga_mpmc_queue_cache_line_size = 64;
+
+/*
+** A slot's sequence is its position when free for that lap's producer, and
+** position + 1 once the producer has filled it for the consumer.
+*/
+struct ga_mpmc_queue_slot_t
+{
+	std::atomic<uint64_t> _sequence;
+	void* _data;
+};
+
+struct ga_mpmc_queue_impl_t
+{
+	char _pad0[k_ga_mpmc_queue_cache_line_size];
+
+	/* Next position to push. */
+	std::atomic<uint64_t> _tail;
+	char _tail_pad[k_ga_mpmc_queue_cache_line_size - sizeof(std::atomic<uint64_t>)];
+
+	/* Next position to pop. */
+	std::atomic<uint64_t> _head;
+	char _head_pad[k_ga_mpmc_queue_cache_line_size - sizeof(std::atomic<uint64_t>)];
+
+	uint64_t _mask;
+	ga_mpmc_queue_slot_t* _slots;
+};
+
+ga_mpmc_queue::ga_mpmc_queue(int capacity)
+{
+	/* Round capacity up to a power of two so positions can be masked. */
+	uint64_t size = 2;
+	while (size < uint64_t(capacity))
+	{
+		size <<= 1;
+	}
+
+	auto impl = new ga_mpmc_queue_impl_t;
+
+	impl->_tail = 0;
+	impl->_head = 0;
+	impl->_mask = size - 1;
+	impl->_slots = new ga_mpmc_queue_slot_t[size];
+	for (uint64_t i = 0; i < size; ++i)
+	{
+		impl->_slots[i]._sequence.store(i, std::memory_order_relaxed);
+	}
+
+	_impl = impl;
+}
+
+ga_mpmc_queue::~ga_mpmc_queue()
+{
+	ga_mpmc_queue_impl_t* impl = static_cast<ga_mpmc_queue_impl_t*>(_impl);
+	delete[] impl->_slots;
+	delete impl;
+}
+
+bool ga_mpmc_queue::push(void* data)
+{
+	return push_n(&data, 1) == 1;
+}
+
+bool ga_mpmc_queue::pop(void** data)
+{
+	return pop_n(data, 1) == 1;
+}
+
+int ga_mpmc_queue::push_n(void* const* data, int count)
+{
+	ga_mpmc_queue_impl_t* impl = static_cast<ga_mpmc_queue_impl_t*>(_impl);
+
+	uint64_t tail = impl->_tail.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		/*
+		** Count the free slots from tail on. Nobody else can fill them
+		** without first moving tail, which the CAS below would catch.
+		*/
+		int free_count = 0;
+		while (free_count < count &&
+			impl->_slots[(tail + free_count) & impl->_mask]._sequence.load(std::memory_order_acquire) == tail + free_count)
+		{
+			++free_count;
+		}
+
+		if (free_count == 0)
+		{
+			/* Full, unless another producer got here first. */
+			uint64_t sequence = impl->_slots[tail & impl->_mask]._sequence.load(std::memory_order_acquire);
+			if (sequence < tail)
+			{
+				return 0;
+			}
+			tail = impl->_tail.load(std::memory_order_relaxed);
+			continue;
+		}
+
+		if (impl->_tail.compare_exchange_weak(tail, tail + free_count, std::memory_order_relaxed))
+		{
+			for (int i = 0; i < free_count; ++i)
+			{
+				ga_mpmc_queue_slot_t& slot = impl->_slots[(tail + i) & impl->_mask];
+				slot._data = data[i];
+				slot._sequence.store(tail + i + 1, std::memory_order_release);
+			}
+			return free_count;
+		}
+	}
+}
+
+int ga_mpmc_queue::pop_n(void** data, int count)
+{
+	ga_mpmc_queue_impl_t* impl = static_cast<ga_mpmc_queue_impl_t*>(_impl);
+
+	uint64_t head = impl->_head.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		/* Count the filled slots from head on, as in push_n. */
+		int full_count = 0;
+		while (full_count < count &&
+			impl->_slots[(head + full_count) & impl->_mask]._sequence.load(std::memory_order_acquire) == head + full_count + 1)
+		{
+			++full_count;
+		}
+
+		if (full_count == 0)
+		{
+			/* Empty, unless another consumer got here first. */
+			uint64_t sequence = impl->_slots[head & impl->_mask]._sequence.load(std::memory_order_acquire);
+			if (sequence < head + 1)
+			{
+				return 0;
+			}
+			head = impl->_head.load(std::memory_order_relaxed);
+			continue;
+		}
+
+		if (impl->_head.compare_exchange_weak(head, head + full_count, std::memory_order_relaxed))
+		{
+			for (int i = 0; i < full_count; ++i)
+			{
+				ga_mpmc_queue_slot_t& slot = impl->_slots[(head + i) & impl->_mask];
+				data[i] = slot._data;
+				slot._sequence.store(head + i + impl->_mask + 1, std::memory_order_release);
+			}
+			return full_count;
+		}
+	}
+}
+
+int ga_mpmc_queue::get_count() const
+{
+	ga_mpmc_queue_impl_t* impl = static_cast<ga_mpmc_queue_impl_t*>(_impl);
+	uint64_t head = impl->_head.load(std::memory_order_relaxed);
+	uint64_t tail = impl->_tail.load(std::memory_order_relaxed);
+	return tail > head ? int(tail - head) : 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+** RPI Game Architecture Engine
+**
+** Portions adapted from:
+** Viper Engine - Copyright (C) 2016 Velan Studios - All Rights Reserved
+**
+** This file is distributed under the MIT License. See LICENSE.txt.
+*/
+
+/*
+** Thread-safe, lock-free, bounded multi-producer multi-consumer queue.
+** An array of slots tagged with sequence numbers, after Dmitry Vyukov:
+** http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+**
+** Unlike ga_queue, a push or pop is a single CAS on its own cache line, and
+** push_n/pop_n move a whole batch with one CAS.
+*/
+class ga_mpmc_queue
+{
+public:
+	ga_mpmc_queue(int capacity);
+	~ga_mpmc_queue();
+
+	/* Returns false if the queue is full. */
+	bool push(void* data);
+	bool pop(void** data);
+
+	/* Push or pop up to count entries in order. Returns how many were moved. */
+	int push_n(void* const* data, int count);
+	int pop_n(void** data, int count);
+
+	int get_count() const;
+
+private:
+	void* _impl;
+};
@@ -26,8 +26,9 @@ union ga_queue_pointer_t
 	ga_queue_nodecount_t _part;
 
 	ga_queue_pointer_t() {}
-	ga_queue_pointer_t(const ga_queue_pointer_t& other) : _entire(other._entire) {}
-	ga_queue_pointer_t& operator=(const ga_queue_pointer_t& other) { _entire = other._entire; return *this; }
+	/* Copies must be real loads, or the compiler may fold away the consistency re-checks. */
+	ga_queue_pointer_t(const ga_queue_pointer_t& other) : _entire(other._atomic.load(std::memory_order_acquire)) {}
+	ga_queue_pointer_t& operator=(const ga_queue_pointer_t& other) { _entire = other._atomic.load(std::memory_order_acquire); return *this; }
 };
 
 struct ga_queue_node_t
@@ -89,12 +90,16 @@ ga_queue::~ga_queue()
 	delete impl;
 }
 
-void ga_queue::push(void* data)
+bool ga_queue::push(void* data)
 {
 	ga_queue_impl_t* impl = static_cast<ga_queue_impl_t*>(_impl);
 
 	/* Allocate a new node for this data. */
 	uint32_t node_index = _alloc_node_index(impl);
+	if (node_index == k_ga_queue_invalid_index)
+	{
+		return false;
+	}
 	ga_queue_node_t* node = _init_node(impl, node_index);
 	node->_data = data;
 
@@ -141,6 +146,8 @@ void ga_queue::push(void* data)
 		impl->_tail._atomic.compare_exchange_strong(tail._entire, link._entire);
 		impl->_count++;
 	}
+
+	return true;
 }
 
 bool ga_queue::pop(void** data)
@@ -207,18 +214,20 @@ static uint32_t _alloc_node_index(ga_queue_impl_t* impl)
 	{
 		ga_queue_pointer_t free_list = impl->_free_list;
 
-		if (free_list._part._index != k_ga_queue_invalid_index)
+		if (free_list._part._index == k_ga_queue_invalid_index)
 		{
-			index = free_list._part._index;
-			ga_queue_pointer_t next = impl->_nodes[index]._next;
+			return k_ga_queue_invalid_index;
+		}
 
-			ga_queue_pointer_t link;
-			link._part._index = next._part._index;
-			link._part._count = free_list._part._count + 1;
-			if (impl->_free_list._atomic.compare_exchange_strong(free_list._entire, link._entire))
-			{
-				break;
-			}
+		index = free_list._part._index;
+		ga_queue_pointer_t next = impl->_nodes[index]._next;
+
+		ga_queue_pointer_t link;
+		link._part._index = next._part._index;
+		link._part._count = free_list._part._count + 1;
+		if (impl->_free_list._atomic.compare_exchange_strong(free_list._entire, link._entire))
+		{
+			break;
 		}
 	}
 
@@ -19,7 +19,8 @@ public:
 	ga_queue(int node_count);
 	~ga_queue();
 
-	void push(void* data);
+	/* Returns false when all nodes are in use. */
+	bool push(void* data);
 	bool pop(void** data);
 
 	int get_count() const;
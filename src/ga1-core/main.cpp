@@ -7,15 +7,24 @@
 ** This file is distributed under the MIT License. See LICENSE.txt.
 */
 
+#include "framework/ga_alloc_count.h"
 #include "framework/ga_camera.h"
+#include "framework/ga_frame_pacer.h"
 #include "framework/ga_compiler_defines.h"
 #include "framework/ga_input.h"
+#include "framework/ga_input_log.h"
 #include "framework/ga_sim.h"
 #include "framework/ga_output.h"
+#include "framework/ga_profiler.h"
 #include "gui/ga_button.h"
 #include "gui/ga_checkbox.h"
 #include "gui/ga_label.h"
+#include "gui/ga_profile_graph.h"
+#include "jobs/ga_cpu_topology.h"
+#include "jobs/ga_frame_arena.h"
+#include "jobs/ga_io.h"
 #include "jobs/ga_job.h"
+#include "jobs/ga_job_trace.h"
 
 #include "entity/ga_entity.h"
 #include "entity/ga_lua_component.h"
@@ -33,24 +42,131 @@
 #define STB_TRUETYPE_IMPLEMENTATION
 #include <stb_truetype.h>
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
 #if defined(GA_MINGW)
 #include <unistd.h>
 #endif
 
 ga_font* g_font = nullptr, *g_font_alt = nullptr;
 static void setup_piano(ga_frame_params* params, ga_audio_component* audio);
+
+// Everything between input and output, run as one stage so it can be a job.
+struct sim_stage_t
+{
+	ga_sim* _sim;
+	ga_audio_component* _audio;
+	ga_frame_params* _params;
+};
+static void run_sim_stage(void* data);
+
+// Frame time and input-to-present latency, to compare frame modes.
+struct frame_stats_t
+{
+	int _frames = 0;
+	std::chrono::high_resolution_clock::duration _frame_time = std::chrono::high_resolution_clock::duration::zero();
+	std::chrono::high_resolution_clock::duration _latency = std::chrono::high_resolution_clock::duration::zero();
+	std::chrono::high_resolution_clock::time_point _last_present;
+
+	// Heap allocations over frames past warmup, which should make none.
+	uint64_t _heap_allocs = 0;
+	int _heap_frames = 0;
+};
+static void draw_frame(ga_output* output, ga_frame_pacer* pacer, ga_frame_params* params, frame_stats_t* stats);
 static void set_root_path(const char* exepath);
 
 int main(int argc, const char** argv)
 {
 	set_root_path(argv[0]);
 
-	ga_job::startup(0xffff, 256, 256);
+	// With -pipelined, output of one frame draws while the sim of the next
+	// runs. Adds a frame of latency in exchange for overlapping the two.
+	bool pipelined = false;
+
+	// With -profile, stage timings are recorded, drawn over the scene, and
+	// written to ga_profile.csv on exit.
+	bool profile = false;
+
+	// -fps sets the paced frame rate, 0 for uncapped. -late_latch syncs
+	// swaps to the display and starts each frame as late as it can, so
+	// input is sampled just before the frame is submitted.
+	int target_rate = 60;
+	bool late_latch = false;
+
+	// -record writes each frame's input and delta time to a log. -replay
+	// plays one back instead of reading devices and quits at its end, so a
+	// session can be rerun as a benchmark; ga_headless -replay takes the
+	// same logs.
+	const char* record_path = nullptr;
+	const char* replay_path = nullptr;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-pipelined") == 0)
+		{
+			pipelined = true;
+		}
+		else if (strcmp(argv[i], "-profile") == 0)
+		{
+			profile = true;
+		}
+		else if (strcmp(argv[i], "-fps") == 0 && i + 1 < argc)
+		{
+			target_rate = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-late_latch") == 0)
+		{
+			late_latch = true;
+		}
+		else if (strcmp(argv[i], "-record") == 0 && i + 1 < argc)
+		{
+			record_path = argv[++i];
+		}
+		else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc)
+		{
+			replay_path = argv[++i];
+		}
+	}
+
+	// Run one job worker per physical core.
+	ga_cpu_topology topology;
+	ga_job_config job_config;
+	job_config._worker_cpus = topology.get_physical_cores();
+	ga_job::startup(job_config);
+	ga_job::set_background_budget(std::chrono::microseconds(2000));
+
+	// Asset reads from jobs suspend rather than block their worker.
+	ga_io::startup();
+
+	ga_profiler::startup();
+	ga_profiler::set_enabled(profile);
 
 	// Create objects for three phases of the frame: input, sim and output.
 	ga_input* input = new ga_input();
 	ga_sim* sim = new ga_sim();
 	ga_output* output = new ga_output(input->get_window());
+	output->set_vsync(late_latch);
+
+	ga_input_recorder recorder;
+	if (record_path)
+	{
+		if (!recorder.open(record_path))
+		{
+			printf("Failed to open %s for recording.\n", record_path);
+		}
+		input->set_recorder(&recorder);
+	}
+	ga_input_player player;
+	if (replay_path)
+	{
+		if (!player.open(replay_path))
+		{
+			printf("Failed to open input log %s.\n", replay_path);
+		}
+		input->set_player(&player);
+	}
 
 	// Create the default fonts:
 	g_font = new ga_font("VeraMono.ttf", 64.0f, 512, 512);
@@ -83,32 +199,138 @@ int main(int argc, const char** argv)
 		
 	sim->add_entity(&demo);
 
+	// Each frame's params, and everything they hold, live in their own
+	// arena. Rewound when the slot comes around again, so steady-state frames
+	// don't go to the heap for their containers. Two slots are enough: the
+	// main thread draws at most one frame while the sim fills in the next.
+	const int k_frame_ring_size = 2;
+	ga_frame_arena frame_arenas[k_frame_ring_size];
+	uint64_t frame_index = 0;
+
+	// Pipelined mode's last frame, simulated but not yet drawn.
+	ga_frame_params* pending = nullptr;
+
+	frame_stats_t stats;
+	ga_frame_pacer pacer(target_rate, late_latch);
+
+	// Keep reading input while the pacer waits, so events between frames
+	// get timestamps close to when they happened.
+	pacer.set_poll([](void* data) { static_cast<ga_input*>(data)->poll(); }, input);
+
+#if GA_COUNT_ALLOCS
+	// Frames to let the arenas grow before counting heap allocations.
+	const uint64_t k_warmup_frames = 10;
+#endif
+
 	// Main loop:
 	while (true)
 	{
+		// Sleep off whatever's left of the frame before sampling input.
+		pacer.wait();
+
+#if GA_COUNT_ALLOCS
+		uint64_t heap_allocs = ga_get_heap_alloc_count();
+#endif
+
 		// We pass frame state through the 3 phases using a params object.
-		ga_frame_params params;
+		ga_frame_arena& arena = frame_arenas[frame_index++ % k_frame_ring_size];
+		arena.reset();
+		ga_frame_params* params = new (arena.alloc(sizeof(ga_frame_params), alignof(ga_frame_params))) ga_frame_params(&arena);
+
+		// Refill the time background jobs may take this frame.
+		ga_job::begin_frame();
+		ga_profiler::begin_frame();
 
 		// Gather user input and current time.
-		if (!input->update(&params))
+		if (!input->update(params))
 		{
+			params->~ga_frame_params();
 			break;
 		}
 
 		// Update the camera.
-		camera->update(&params);
+		camera->update(params);
+
+		sim_stage_t stage = { sim, &demo_audio, params };
+		if (pipelined)
+		{
+			// Simulate this frame on the workers while drawing the last one.
+			// GL stays on the main thread.
+			ga_job_decl_t decl;
+			decl._entry = run_sim_stage;
+			decl._data = &stage;
+
+			ga_job_counter counter;
+			ga_job::run(&decl, 1, &counter);
+
+			if (pending)
+			{
+				draw_frame(output, &pacer, pending, &stats);
+				pending->~ga_frame_params();
+			}
+
+			ga_job::wait(&counter);
+			pending = params;
+		}
+		else
+		{
+			run_sim_stage(&stage);
+			draw_frame(output, &pacer, params, &stats);
+			params->~ga_frame_params();
+		}
 
-		// Run gameplay.
-		sim->update(&params);
+#if GA_COUNT_ALLOCS
+		if (frame_index > k_warmup_frames)
+		{
+			stats._heap_allocs += ga_get_heap_alloc_count() - heap_allocs;
+			stats._heap_frames++;
+		}
+#endif
+	}
 
-		// create GUI for audio component
-		setup_piano(&params, &demo_audio);
+	if (pending)
+	{
+		pending->~ga_frame_params();
+	}
+
+	if (stats._frames > 1)
+	{
+		printf("%s: %d frames, %.2f ms per frame, %.2f ms input to present\n",
+			pipelined ? "pipelined" : "sequential", stats._frames,
+			std::chrono::duration<double, std::milli>(stats._frame_time).count() / (stats._frames - 1),
+			std::chrono::duration<double, std::milli>(stats._latency).count() / stats._frames);
+	}
+	if (stats._heap_frames > 0)
+	{
+		int arena_blocks = 0;
+		for (int i = 0; i < k_frame_ring_size; ++i)
+		{
+			arena_blocks += frame_arenas[i].get_block_count();
+		}
+		printf("%.2f heap allocations per frame after warmup, %d frame arena blocks\n",
+			double(stats._heap_allocs) / stats._heap_frames, arena_blocks);
+	}
 
-		// Perform the late update.
-		sim->late_update(&params);
+	if (record_path)
+	{
+		printf("recorded %d frames of input to %s\n", recorder.get_frame_count(), record_path);
+	}
+	if (replay_path)
+	{
+		printf("replayed %d frames of input from %s\n", player.get_frame_count(), replay_path);
+	}
 
-		// Draw to screen.
-		output->update(&params);
+	ga_frame_pacer_stats pacing = pacer.get_stats();
+	if (pacing._presents > 1)
+	{
+		printf("present interval %.2f ms mean, %.2f min, %.2f max, %.2f deviation; %.0f ms asleep, %.0f ms spinning\n",
+			pacing._mean_interval.count(), pacing._min_interval.count(), pacing._max_interval.count(),
+			pacing._interval_deviation.count(), pacing._sleep_time.count(), pacing._spin_time.count());
+	}
+
+	if (profile)
+	{
+		ga_profiler::write_csv("ga_profile.csv");
 	}
 
 	delete output;
@@ -116,6 +338,12 @@ int main(int argc, const char** argv)
 	delete input;
 	delete camera;
 
+#if GA_JOB_TRACE
+	ga_job_trace::dump("ga_job_trace.json", 8);
+#endif
+
+	ga_profiler::shutdown();
+	ga_io::shutdown();
 	ga_job::shutdown();
 
 	return 0;
@@ -126,9 +354,50 @@ bool use_guitar, octave_up, distort, echo, tremolo, chorus;
 float pan = 0.0f, volume = 1.0f, low_gain = 0.0f, mid_gain = 0.0f, high_gain = 0.0f;
 int curr_index = 0;
 
+static void run_sim_stage(void* data)
+{
+	sim_stage_t* stage = static_cast<sim_stage_t*>(data);
+
+	GA_PROFILE_SCOPE("sim");
+
+	// Run gameplay.
+	stage->_sim->update(stage->_params);
+
+	// create GUI for audio component
+	{
+		GA_PROFILE_SCOPE("sim/gui");
+		setup_piano(stage->_params, stage->_audio);
+
+		if (ga_profiler::is_enabled())
+		{
+			ga_profile_graph(380.0f, 120.0f, stage->_params);
+		}
+	}
+
+	// Perform the late update.
+	stage->_sim->late_update(stage->_params);
+}
+
+static void draw_frame(ga_output* output, ga_frame_pacer* pacer, ga_frame_params* params, frame_stats_t* stats)
+{
+	// Draw to screen.
+	output->update(params);
+	pacer->mark_present();
+
+	auto now = std::chrono::high_resolution_clock::now();
+	if (stats->_frames > 0)
+	{
+		stats->_frame_time += now - stats->_last_present;
+	}
+	stats->_latency += now - params->_current_time;
+	stats->_last_present = now;
+	stats->_frames++;
+}
+
 static void setup_piano(ga_frame_params *params, ga_audio_component* audio)
 {
-	std::vector<ga_button> keys;
+	ga_frame_vector<ga_button> keys(params->_arena);
+	keys.reserve(13);
 
 	keys.push_back(ga_button("C", 390, 600, params));
 	keys.push_back(ga_button("C#", 420, 540, params, true));
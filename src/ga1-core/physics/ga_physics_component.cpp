@@ -12,6 +12,7 @@
 #include "ga_rigid_body.h"
 
 #include "entity/ga_entity.h"
+#include "framework/ga_profiler.h"
 
 ga_physics_component::ga_physics_component(ga_entity* ent, ga_shape* shape, float mass)
 	: ga_component(ent)
@@ -27,21 +28,29 @@ ga_physics_component::~ga_physics_component()
 
 void ga_physics_component::update(ga_frame_params* params)
 {
+	GA_PROFILE_SCOPE("sim/update/ga_physics_component");
+
 	// First, re-sync the rigid body's transform with the entity's.
 	_body->_transform = get_entity()->get_transform();
 
 #if GA_PHYSICS_DEBUG_DRAW
-	ga_dynamic_drawcall draw;
+	ga_dynamic_drawcall draw(params->_arena);
 	_body->get_debug_draw(&draw);
 
-	while (params->_dynamic_drawcall_lock.test_and_set(std::memory_order_acquire)) {}
-	params->_dynamic_drawcalls.push_back(draw);
-	params->_dynamic_drawcall_lock.clear(std::memory_order_release);
+	params->_dynamic_drawcalls.push_back(std::move(draw));
 #endif
 }
 
 void ga_physics_component::late_update(ga_frame_params* params)
 {
+	GA_PROFILE_SCOPE("sim/late_update/ga_physics_component");
+
 	// Sync the entity's transform with the rigid body's.
 	get_entity()->set_transform(_body->_transform);
 }
+
+void ga_physics_component::get_access(uint64_t* reads, uint64_t* writes) const
+{
+	*reads = ga_world::get_signature<ga_transform_state, ga_physics_state>();
+	*writes = ga_world::get_signature<ga_transform_state, ga_physics_state>();
+}
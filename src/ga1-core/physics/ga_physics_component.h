@@ -23,6 +23,7 @@ public:
 
 	virtual void update(struct ga_frame_params* params) override;
 	virtual void late_update(struct ga_frame_params* params) override;
+	virtual void get_access(uint64_t* reads, uint64_t* writes) const override;
 
 	class ga_rigid_body* get_rigid_body() const { return _body; }
 
@@ -14,6 +14,8 @@
 
 #include "framework/ga_drawcall.h"
 #include "framework/ga_frame_params.h"
+#include "framework/ga_profiler.h"
+#include "jobs/ga_job.h"
 
 #include <algorithm>
 #include <assert.h>
@@ -23,7 +25,10 @@ typedef bool (*intersection_func_t)(const ga_shape* a, const ga_mat4f& transform
 
 static intersection_func_t k_dispatch_table[k_shape_count][k_shape_count];
 
-ga_physics_world::ga_physics_world()
+// Rigid bodies integrated per chunk by one job.
+static const int k_integration_grain = 64;
+
+ga_physics_world::ga_physics_world() : _step_bodies(nullptr), _step_body_count(0)
 {
 	// Clear the dispatch table.
 	for (int i = 0; i < k_shape_count; ++i)
@@ -66,49 +71,69 @@ void ga_physics_world::remove_rigid_body(ga_rigid_body* body)
 
 void ga_physics_world::step(ga_frame_params* params)
 {
+	GA_PROFILE_SCOPE("physics");
+
+	// Step a copy of the body list, so jobs can add and remove bodies while
+	// the step waits on them. Those changes take effect next step. The copy
+	// only lives for this frame, so it comes from scratch memory.
 	while (_bodies_lock.test_and_set(std::memory_order_acquire)) {}
+	_step_body_count = int(_bodies.size());
+	_step_bodies = ga_job::alloc_scratch_array<ga_rigid_body*>(_step_body_count);
+	std::copy(_bodies.begin(), _bodies.end(), _step_bodies);
+	_bodies_lock.clear(std::memory_order_release);
 
-	// Step the physics sim.
-	for (int i = 0; i < _bodies.size(); ++i)
+	// Step the physics sim. Bodies integrate independently, so spread them
+	// across the job system.
+	struct step_data_t
 	{
-		if (_bodies[i]->_flags & k_static) continue;
-
-		ga_rigid_body* body = _bodies[i];
+		ga_physics_world* _world;
+		ga_frame_params* _params;
+	};
+	step_data_t step_data = { this, params };
 
-		if ((_bodies[i]->_flags & k_weightless) == 0)
+	ga_job::parallel_for(0, _step_body_count, k_integration_grain, [](int begin, int end, void* data)
+	{
+		auto step_data = static_cast<step_data_t*>(data);
+		ga_physics_world* world = step_data->_world;
+		for (int i = begin; i < end; ++i)
 		{
-			body->_forces.push_back(_gravity);
-		}
+			ga_rigid_body* body = world->_step_bodies[i];
 
-		step_linear_dynamics(params, body);
-		step_angular_dynamics(params, body);
-	}
+			if (body->_flags & k_static) continue;
 
-	test_intersections(params);
+			if ((body->_flags & k_weightless) == 0)
+			{
+				body->_forces.push_back(world->_gravity);
+			}
 
-	_bodies_lock.clear(std::memory_order_release);
+			world->step_linear_dynamics(step_data->_params, body);
+			world->step_angular_dynamics(step_data->_params, body);
+		}
+	}, &step_data);
+
+	test_intersections(params);
 }
 
 void ga_physics_world::test_intersections(ga_frame_params* params)
 {
 	// Intersection tests. Naive N^2 comparisons.
-	for (int i = 0; i < _bodies.size(); ++i)
+	for (int i = 0; i < _step_body_count; ++i)
 	{
-		for (int j = i + 1; j < _bodies.size(); ++j)
+		for (int j = i + 1; j < _step_body_count; ++j)
 		{
-			ga_shape* shape_a = _bodies[i]->_shape;
-			ga_shape* shape_b = _bodies[j]->_shape;
+			ga_shape* shape_a = _step_bodies[i]->_shape;
+			ga_shape* shape_b = _step_bodies[j]->_shape;
 			intersection_func_t func = k_dispatch_table[shape_a->get_type()][shape_b->get_type()];
 
 			ga_collision_info info;
-			bool collision = func(shape_a, _bodies[i]->_transform, shape_b, _bodies[j]->_transform, &info);
+			bool collision = func(shape_a, _step_bodies[i]->_transform, shape_b, _step_bodies[j]->_transform, &info);
 			if (collision)
 			{
 				std::time_t time = std::chrono::system_clock::to_time_t(
 					std::chrono::system_clock::now());
 
 #if defined(GA_PHYSICS_DEBUG_DRAW)
-				ga_dynamic_drawcall collision_draw;
+				ga_dynamic_drawcall collision_draw(params->_arena);
 				collision_draw._positions.push_back(ga_vec3f::zero_vector());
 				collision_draw._positions.push_back(info._normal);
 				collision_draw._indices.push_back(0);
@@ -118,16 +143,14 @@ void ga_physics_world::test_intersections(ga_frame_params* params)
 				collision_draw._material = nullptr;
 				collision_draw._transform.make_translation(info._point);
 
-				while (params->_dynamic_drawcall_lock.test_and_set(std::memory_order_acquire)) {}
-				params->_dynamic_drawcalls.push_back(collision_draw);
-				params->_dynamic_drawcall_lock.clear(std::memory_order_release);
+				params->_dynamic_drawcalls.push_back(std::move(collision_draw));
 #endif
 				// We should not attempt to resolve collisions if we're paused and have not single stepped.
 				bool should_resolve = params->_delta_time > std::chrono::milliseconds(0) || params->_single_step;
 
 				if (should_resolve)
 				{
-					resolve_collision(_bodies[i], _bodies[j], &info);
+					resolve_collision(_step_bodies[i], _step_bodies[j], &info);
 				}
 			}
 		}
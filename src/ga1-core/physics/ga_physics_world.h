@@ -39,6 +39,10 @@ private:
 	std::vector<ga_rigid_body*> _bodies;
 	std::atomic_flag _bodies_lock = ATOMIC_FLAG_INIT;
 
+	// The bodies as of the start of the current step, in job scratch memory.
+	ga_rigid_body** _step_bodies;
+	int _step_body_count;
+
 	ga_vec3f _gravity;
 
 	void step_linear_dynamics(ga_frame_params* params, ga_rigid_body* body);
@@ -51,6 +51,12 @@ void ga_playermove_component::update(ga_frame_params* params)
 	}
 }
 
+void ga_playermove_component::get_access(uint64_t* reads, uint64_t* writes) const
+{
+	*reads = ga_world::get_signature<ga_transform_state>();
+	*writes = ga_world::get_signature<ga_transform_state>();
+}
+
 void ga_playermove_component::set_move_when_paused(bool state)
 {
 	_move_when_paused = state;
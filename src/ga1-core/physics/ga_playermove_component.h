@@ -21,6 +21,7 @@ public:
 	virtual ~ga_playermove_component();
 
 	virtual void update(struct ga_frame_params* params) override;
+	virtual void get_access(uint64_t* reads, uint64_t* writes) const override;
 
 	void set_move_when_paused(bool state);
 
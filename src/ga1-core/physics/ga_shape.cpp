@@ -131,24 +131,34 @@ ga_vec3f ga_aabb::get_offset_to_point(const ga_mat4f& transform, const ga_vec3f&
 }
 
 void ga_oobb::get_corners(std::vector<ga_vec3f>& corners) const
+{
+	ga_vec3f array[8];
+	get_corners(array);
+	corners.insert(corners.end(), array, array + 8);
+}
+
+void ga_oobb::get_corners(ga_vec3f corners[8]) const
 {
 	ga_vec3f x_hvec = _half_vectors[0];
 	ga_vec3f y_hvec = _half_vectors[1];
 	ga_vec3f z_hvec = _half_vectors[2];
 
-	corners.push_back(_center - x_hvec - y_hvec - z_hvec);
-	corners.push_back(_center - x_hvec - y_hvec + z_hvec);
-	corners.push_back(_center - x_hvec + y_hvec - z_hvec);
-	corners.push_back(_center - x_hvec + y_hvec + z_hvec);
-	corners.push_back(_center + x_hvec - y_hvec - z_hvec);
-	corners.push_back(_center + x_hvec - y_hvec + z_hvec);
-	corners.push_back(_center + x_hvec + y_hvec - z_hvec);
-	corners.push_back(_center + x_hvec + y_hvec + z_hvec);
+	corners[0] = _center - x_hvec - y_hvec - z_hvec;
+	corners[1] = _center - x_hvec - y_hvec + z_hvec;
+	corners[2] = _center - x_hvec + y_hvec - z_hvec;
+	corners[3] = _center - x_hvec + y_hvec + z_hvec;
+	corners[4] = _center + x_hvec - y_hvec - z_hvec;
+	corners[5] = _center + x_hvec - y_hvec + z_hvec;
+	corners[6] = _center + x_hvec + y_hvec - z_hvec;
+	corners[7] = _center + x_hvec + y_hvec + z_hvec;
 }
 
 void ga_oobb::get_debug_draw(const ga_mat4f& transform, ga_dynamic_drawcall* drawcall)
 {
-	get_corners(drawcall->_positions);
+	ga_vec3f corners[8];
+	get_corners(corners);
+	drawcall->_positions.reserve(12);
+	drawcall->_positions.insert(drawcall->_positions.end(), corners, corners + 8);
 	drawcall->_positions.push_back(ga_vec3f::zero_vector());
 	drawcall->_positions.push_back(_half_vectors[0]);
 	drawcall->_positions.push_back(_half_vectors[1]);
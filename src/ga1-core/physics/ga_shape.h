@@ -120,6 +120,7 @@ struct ga_oobb final : ga_shape
 	ga_vec3f get_offset_to_point(const ga_mat4f& transform, const ga_vec3f& point) const override;
 
 	void get_corners(std::vector<ga_vec3f>& corners) const;
+	void get_corners(ga_vec3f corners[8]) const;
 };
 
 /*